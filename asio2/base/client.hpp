@@ -87,32 +87,34 @@ namespace asio2::detail
 
 		/**
 		 * @constructor
+		 * @param    : concurrency_or_iopool - the size of the owned io_context pool, or a user
+		 * supplied io_context pool refrence which can be shared by many clients.
 		 */
-		template<class ...Args>
+		template<class Concurrency, class ...Args>
 		explicit client_impl_t(
-			std::size_t concurrency,
+			Concurrency&& concurrency_or_iopool,
 			std::size_t init_buffer_size,
 			std::size_t max_buffer_size,
 			Args&&... args
 		)
 			: super()
-			, iopool_cp(concurrency)
+			, iopool_cp(std::forward<Concurrency>(concurrency_or_iopool))
 			, event_queue_cp<derived_t>()
 			, user_data_cp<derived_t>()
 			, connect_time_cp<derived_t>()
 			, active_time_cp<derived_t>()
-			, socket_cp<derived_t, socket_t>(iopool_.get(0).context(), std::forward<Args>(args)...)
+			, socket_cp<derived_t, socket_t>(iopool_.get(iopool_index_).context(), std::forward<Args>(args)...)
 			, connect_cp<derived_t, socket_t>()
 			, local_endpoint_cp<derived_t, typename socket_t::lowest_layer_type::endpoint_type>()
-			, reconnect_timer_cp<derived_t, false>(iopool_.get(0))
-			, user_timer_cp<derived_t, false>(iopool_.get(0))
-			, connect_timeout_cp<derived_t, false>(iopool_.get(0))
-			, send_cp<derived_t, false>(iopool_.get(0))
+			, reconnect_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, connect_timeout_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, send_cp<derived_t, false>(iopool_.get(iopool_index_))
 			, post_cp<derived_t>()
 			, rallocator_()
 			, wallocator_()
 			, listener_()
-			, io_(iopool_.get(0))
+			, io_(iopool_.get(iopool_index_))
 			, buffer_(init_buffer_size, max_buffer_size)
 		{
 		}
@@ -73,7 +73,10 @@ namespace asio2::detail
 				socket.open(derive.local_endpoint().protocol());
 
 				// Connect succeeded. set the keeplive values
-				socket.set_option(typename socket_t::reuse_address(true)); // set port reuse
+				// set port reuse only for the fixed local port, otherwise the kernel may assign the same
+				// ephemeral port to several udp sockets which have the SO_REUSEADDR option.
+				if (derive.local_endpoint().port() != 0)
+					socket.set_option(typename socket_t::reuse_address(true)); // set port reuse
 
 				if constexpr (std::is_same_v<typename socket_t::protocol_type, asio::ip::tcp>)
 					derive.keep_alive_options();
@@ -21,6 +21,9 @@
 #include <asio2/base/iopool.hpp>
 #include <asio2/base/error.hpp>
 
+#include <asio2/base/detail/allocator.hpp>
+#include <asio2/base/detail/timer_wheel.hpp>
+
 namespace asio2::detail
 {
 	template<class derived_t, bool isSession>
@@ -33,7 +36,7 @@ namespace asio2::detail
 		explicit connect_timeout_cp(io_t & timer_io)
 			: derive(static_cast<derived_t&>(*this))
 			, timeout_timer_io_(timer_io)
-			, timeout_timer_(timer_io.context())
+			, timeout_timer_(_make_timeout_timer(timer_io))
 		{
 		}
 
@@ -61,13 +64,25 @@ namespace asio2::detail
 		template<class Rep, class Period>
 		inline void _post_timeout_timer(std::chrono::duration<Rep, Period> duration, std::shared_ptr<derived_t> this_ptr)
 		{
-			this->timeout_timer_.expires_after(duration);
-			this->timeout_timer_.async_wait(asio::bind_executor(this->timeout_timer_io_.strand(),
-				[this, self_ptr = std::move(this_ptr)](const error_code & ec) mutable
+			static_assert(isSession, "the timer wheel is only used by the session");
+
+			// the timer wheel can only be used in the strand of the io
+			if (!this->timeout_timer_io_.strand().running_in_this_thread())
 			{
-				derive._handle_timeout_timer(ec, std::move(self_ptr));
+				asio::post(this->timeout_timer_io_.strand(), make_allocator(derive.wallocator(),
+					[this, duration, self_ptr = std::move(this_ptr)]() mutable
+				{
+					derive._post_timeout_timer(duration, std::move(self_ptr));
+				}));
+				return;
+			}
+
+			this->timeout_timer_io_.wheel().start(this->timeout_timer_, duration,
+				[this, self_ptr = std::move(this_ptr)]() mutable
+			{
+				derive._handle_timeout_timer(error_code{}, std::move(self_ptr));
 				this->timer_canceled_.clear();
-			}));
+			});
 		}
 
 		inline void _handle_timeout_timer(const error_code & ec, std::shared_ptr<derived_t> this_ptr)
@@ -111,18 +126,53 @@ namespace asio2::detail
 			this->timer_canceled_.test_and_set();
 			try
 			{
-				this->timeout_timer_.cancel();
+				if constexpr (isSession)
+				{
+					if (this->timeout_timer_io_.strand().running_in_this_thread())
+					{
+						this->timeout_timer_io_.wheel().cancel(this->timeout_timer_);
+					}
+					else
+					{
+						asio::post(this->timeout_timer_io_.strand(), make_allocator(derive.wallocator(),
+							[this, self_ptr = derive.selfptr()]()
+						{
+							this->timeout_timer_io_.wheel().cancel(this->timeout_timer_);
+						}));
+					}
+				}
+				else
+				{
+					this->timeout_timer_.cancel();
+				}
 			}
 			catch (system_error &) {}
 			catch (std::exception &) {}
 		}
 
+		/**
+		 * the sessions are numerous, so the session timer is linked into the timer wheel of the io,
+		 * the client timer is a asio timer, because the client waits for it with a future.
+		 */
+		static inline auto _make_timeout_timer(io_t & timer_io)
+		{
+			if constexpr (isSession)
+			{
+				std::ignore = timer_io;
+				return timer_wheel::timer{};
+			}
+			else
+			{
+				return asio::steady_timer(timer_io.context());
+			}
+		}
+
 	protected:
 		derived_t                                 & derive;
 
 		io_t                                      & timeout_timer_io_;
 
-		asio::steady_timer                          timeout_timer_;
+		std::conditional_t<isSession, timer_wheel::timer, asio::steady_timer> timeout_timer_;
 
 		std::atomic_flag                            timer_canceled_ = ATOMIC_FLAG_INIT;
 
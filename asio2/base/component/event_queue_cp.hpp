@@ -16,11 +16,12 @@
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
 #include <cstdint>
+#include <atomic>
 #include <memory>
 #include <functional>
 #include <string>
 #include <future>
-#include <queue>
+#include <deque>
 #include <tuple>
 #include <utility>
 #include <string_view>
@@ -38,6 +39,30 @@ namespace asio2::detail
 	template<class derived_t>
 	class event_queue_cp
 	{
+	protected:
+		/// the task node of the event queue, the task object is stored in the node directly, so one
+		/// task only needs one allocation.
+		struct event_node_base
+		{
+			event_node_base(bool send) : is_send(send) {}
+			virtual ~event_node_base() = default;
+			virtual bool invoke() = 0;
+
+			event_node_base     * next = nullptr;
+
+			bool                  is_send = false;
+		};
+
+		template<class Function>
+		struct event_node : public event_node_base
+		{
+			template<class F>
+			event_node(F&& f, bool send) : event_node_base(send), fn(std::forward<F>(f)) {}
+			virtual bool invoke() override { return fn(); }
+
+			Function              fn;
+		};
+
 	public:
 		/**
 		 * @constructor
@@ -47,7 +72,18 @@ namespace asio2::detail
 		/**
 		 * @destructor
 		 */
-		~event_queue_cp() = default;
+		~event_queue_cp()
+		{
+#if defined(ASIO2_SEND_CORE_ASYNC)
+			event_node_base* node = this->pending_.exchange(nullptr, std::memory_order_acquire);
+			while (node)
+			{
+				event_node_base* next = node->next;
+				delete node;
+				node = next;
+			}
+#endif
+		}
 
 	public:
 		/**
@@ -57,32 +93,103 @@ namespace asio2::detail
 		template<class Callback>
 		inline derived_t & push_event(Callback&& f)
 		{
+			return this->_push_event(std::forward<Callback>(f), false);
+		}
+
+		/**
+		 * push a data sending task to the tail of the event queue, the sending tasks which are
+		 * next to each other can be gathered into one write operation by the send op.
+		 * Callback signature : bool()
+		 */
+		template<class Callback>
+		inline derived_t & push_send_event(Callback&& f)
+		{
+			return this->_push_event(std::forward<Callback>(f), true);
+		}
+
+		/**
+		 * Removes an element from the front of the event queue.
+		 * and then execute the next element of the queue.
+		 */
+		template<typename = void>
+		inline derived_t & next_event()
+		{
 #if defined(ASIO2_SEND_CORE_ASYNC)
 			// Make sure we run on the strand
 			if (derive.io().strand().running_in_this_thread())
 			{
-				bool empty = this->events_.empty();
-				this->events_.emplace(std::forward<Callback>(f));
-				if (empty)
+				if (!this->events_.empty())
 				{
-					(this->events_.front())();
+					this->events_.pop_front();
+
+					if (!this->events_.empty())
+					{
+						this->events_.front()->invoke();
+					}
 				}
 				return (derive);
 			}
 
 			asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
-				[this, p = derive.selfptr(), f = std::forward<Callback>(f)]() mutable
+				[this, p = derive.selfptr()]() mutable
 			{
-				bool empty = this->events_.empty();
-				this->events_.emplace(std::move(f));
-				if (empty)
+				if (!this->events_.empty())
 				{
-					(this->events_.front())();
+					this->events_.pop_front();
+
+					if (!this->events_.empty())
+					{
+						this->events_.front()->invoke();
+					}
 				}
 			}));
 
 			return (derive);
 #else
+			ASIO2_ASSERT(false);
+			return (derive);
+#endif
+		}
+
+	protected:
+		template<class Callback>
+		inline derived_t & _push_event(Callback&& f, bool is_send)
+		{
+#if defined(ASIO2_SEND_CORE_ASYNC)
+			std::unique_ptr<event_node_base> node = std::make_unique<event_node<std::decay_t<Callback>>>(
+				std::forward<Callback>(f), is_send);
+
+			// Make sure we run on the strand
+			if (derive.io().strand().running_in_this_thread())
+			{
+				this->_emplace_event(std::move(node));
+				return (derive);
+			}
+
+			// push the task to the lock free pending list, only the producer which pushes the task
+			// into the empty list posts the drain handler, the others reuse the scheduled drain.
+			event_node_base* head = this->pending_.load(std::memory_order_relaxed);
+			do
+			{
+				node->next = head;
+			} while (!this->pending_.compare_exchange_weak(head, node.get(),
+				std::memory_order_release, std::memory_order_relaxed));
+
+			node.release();
+
+			if (head == nullptr)
+			{
+				asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
+					[this, p = derive.selfptr()]() mutable
+				{
+					this->_drain_events();
+				}));
+			}
+
+			return (derive);
+#else
+			std::ignore = is_send;
+
 			// Make sure we run on the strand
 			if (derive.io().strand().running_in_this_thread())
 			{
@@ -100,54 +207,89 @@ namespace asio2::detail
 #endif
 		}
 
+#if defined(ASIO2_SEND_CORE_ASYNC)
+		inline void _emplace_event(std::unique_ptr<event_node_base> node)
+		{
+			bool empty = this->events_.empty();
+			this->events_.emplace_back(std::move(node));
+			if (empty)
+			{
+				this->events_.front()->invoke();
+			}
+		}
+
 		/**
-		 * Removes an element from the front of the event queue.
-		 * and then execute the next element of the queue.
+		 * Move all the pending tasks which are pushed by the other threads to the event queue,
+		 * the pending list is a stack, so reverse it to keep the tasks in the pushed order.
 		 */
-		template<typename = void>
-		inline derived_t & next_event()
+		inline void _drain_events()
 		{
-#if defined(ASIO2_SEND_CORE_ASYNC)
-			// Make sure we run on the strand
-			if (derive.io().strand().running_in_this_thread())
+			event_node_base* head = this->pending_.exchange(nullptr, std::memory_order_acquire);
+
+			event_node_base* node = nullptr;
+			while (head)
 			{
-				if (!this->events_.empty())
-				{
-					this->events_.pop();
+				event_node_base* next = head->next;
+				head->next = node;
+				node = head;
+				head = next;
+			}
 
-					if (!this->events_.empty())
-					{
-						(this->events_.front())();
-					}
-				}
-				return (derive);
+			while (node)
+			{
+				event_node_base* next = node->next;
+				node->next = nullptr;
+				this->_emplace_event(std::unique_ptr<event_node_base>(node));
+				node = next;
 			}
+		}
+#endif
 
-			asio::post(derive.io().strand(), make_allocator(derive.wallocator(),
-				[this, p = derive.selfptr()]() mutable
+#if defined(ASIO2_SEND_CORE_ASYNC)
+		/**
+		 * Execute the sending tasks which are next to the front task, while the predicate returns
+		 * true. The executed tasks are still kept in the queue, so the objects captured by them are
+		 * valid until they are removed by _pop_events. Must be called on the strand by the front task.
+		 * Predicate signature : bool()
+		 * @return : the count of the executed tasks
+		 */
+		template<class Predicate>
+		inline std::size_t _gather_events(Predicate&& pred)
+		{
+			ASIO2_ASSERT(derive.io().strand().running_in_this_thread());
+
+			std::size_t count = 0;
+			for (std::size_t i = 1; i < this->events_.size() && this->events_[i]->is_send && pred(); ++i, ++count)
 			{
-				if (!this->events_.empty())
-				{
-					this->events_.pop();
+				this->events_[i]->invoke();
+			}
+			return count;
+		}
 
-					if (!this->events_.empty())
-					{
-						(this->events_.front())();
-					}
-				}
-			}));
+		/**
+		 * Removes the elements from the front of the event queue, without executing the next element.
+		 */
+		inline void _pop_events(std::size_t count)
+		{
+			ASIO2_ASSERT(derive.io().strand().running_in_this_thread());
 
-			return (derive);
-#else
-			ASIO2_ASSERT(false);
-			return (derive);
-#endif
+			for (; count > 0 && !this->events_.empty(); --count)
+			{
+				this->events_.pop_front();
+			}
 		}
+#endif
 
 	protected:
-		derived_t                         & derive;
+		derived_t                                     & derive;
 
-		std::queue<std::function<bool()>>   events_;
+		/// the tasks are stored by pointer, so the objects captured by them are stable when new tasks are pushed
+		std::deque<std::unique_ptr<event_node_base>>    events_;
+
+#if defined(ASIO2_SEND_CORE_ASYNC)
+		/// the tasks which are pushed by the other threads and are waiting to be moved to the events_
+		std::atomic<event_node_base*>                   pending_{ nullptr };
+#endif
 	};
 }
 
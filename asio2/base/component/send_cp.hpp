@@ -78,7 +78,7 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this,
+				this->derive.push_send_event([this,
 					data = this->derive._data_persistence(std::forward<T>(data))]() mutable
 				{
 					return this->derive._do_send(data, [](const error_code&, std::size_t) {});
@@ -130,7 +130,7 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(s, count)]() mutable
+				this->derive.push_send_event([this, data = this->derive._data_persistence(s, count)]() mutable
 				{
 					return this->derive._do_send(data, [](const error_code&, std::size_t) {});
 				});
@@ -167,7 +167,7 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(std::forward<T>(data)),
+				this->derive.push_send_event([this, data = this->derive._data_persistence(std::forward<T>(data)),
 					promise = std::move(promise)]() mutable
 				{
 					return this->derive._do_send(data, [&promise](const error_code& ec, std::size_t bytes_sent)
@@ -233,7 +233,7 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(s, count),
+				this->derive.push_send_event([this, data = this->derive._data_persistence(s, count),
 					promise = std::move(promise)]() mutable
 				{
 					return this->derive._do_send(data, [&promise](const error_code& ec, std::size_t bytes_sent)
@@ -279,7 +279,7 @@ namespace asio2::detail
 				if (!this->derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(std::forward<T>(data)),
+				this->derive.push_send_event([this, data = this->derive._data_persistence(std::forward<T>(data)),
 					fn = std::forward<Callback>(fn)]() mutable
 				{
 					return this->derive._do_send(data, [&fn](const error_code&, std::size_t bytes_sent)
@@ -337,7 +337,7 @@ namespace asio2::detail
 				if (!s)
 					asio::detail::throw_error(asio::error::invalid_argument);
 
-				this->derive.push_event([this, data = this->derive._data_persistence(s, count),
+				this->derive.push_send_event([this, data = this->derive._data_persistence(s, count),
 					fn = std::forward<Callback>(fn)]() mutable
 				{
 					return this->derive._do_send(data, [&fn](const error_code&, std::size_t bytes_sent)
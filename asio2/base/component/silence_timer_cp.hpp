@@ -21,6 +21,9 @@
 #include <asio2/base/iopool.hpp>
 #include <asio2/base/error.hpp>
 
+#include <asio2/base/detail/allocator.hpp>
+#include <asio2/base/detail/timer_wheel.hpp>
+
 namespace asio2::detail
 {
 	template<class derived_t, bool isSession>
@@ -33,7 +36,6 @@ namespace asio2::detail
 		explicit silence_timer_cp(io_t & timer_io)
 			: derive(static_cast<derived_t&>(*this))
 			, silence_timer_io_(timer_io)
-			, silence_timer_(timer_io.context())
 		{
 		}
 
@@ -68,12 +70,22 @@ namespace asio2::detail
 			// start the timer of check silence timeout
 			if (duration > std::chrono::milliseconds(0))
 			{
-				this->silence_timer_.expires_after(duration);
-				this->silence_timer_.async_wait(asio::bind_executor(this->silence_timer_io_.strand(),
-					[this, self_ptr = std::move(this_ptr)](const error_code & ec)
+				// the timer wheel can only be used in the strand of the io
+				if (!this->silence_timer_io_.strand().running_in_this_thread())
+				{
+					asio::post(this->silence_timer_io_.strand(), make_allocator(derive.wallocator(),
+						[this, duration, self_ptr = std::move(this_ptr)]() mutable
+					{
+						derive._post_silence_timer(duration, std::move(self_ptr));
+					}));
+					return;
+				}
+
+				this->silence_timer_io_.wheel().start(this->silence_timer_, duration,
+					[this, self_ptr = std::move(this_ptr)]() mutable
 				{
-					derive._handle_silence_timer(ec, std::move(self_ptr));
-				}));
+					derive._handle_silence_timer(error_code{}, std::move(self_ptr));
+				});
 			}
 		}
 
@@ -105,7 +117,19 @@ namespace asio2::detail
 			try
 			{
 				this->silence_timer_canceled_.test_and_set();
-				this->silence_timer_.cancel();
+
+				if (this->silence_timer_io_.strand().running_in_this_thread())
+				{
+					this->silence_timer_io_.wheel().cancel(this->silence_timer_);
+				}
+				else
+				{
+					asio::post(this->silence_timer_io_.strand(), make_allocator(derive.wallocator(),
+						[this, self_ptr = derive.selfptr()]()
+					{
+						this->silence_timer_io_.wheel().cancel(this->silence_timer_);
+					}));
+				}
 			}
 			catch (system_error &) {}
 			catch (std::exception &) {}
@@ -117,8 +141,8 @@ namespace asio2::detail
 		/// The io (include io_context and strand) used to handle the recv/send event.
 		io_t                                      & silence_timer_io_;
 
-		/// timer for session silence time out
-		asio::steady_timer                          silence_timer_;
+		/// timer for session silence time out, it's linked into the timer wheel of the io
+		timer_wheel::timer                          silence_timer_;
 
 		/// 
 		std::atomic_flag                            silence_timer_canceled_ = ATOMIC_FLAG_INIT;
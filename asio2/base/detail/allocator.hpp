@@ -15,10 +15,12 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 #include <utility>
 #include <atomic>
+#include <mutex>
 #include <fstream>
 
 namespace asio2::detail
@@ -39,6 +41,206 @@ namespace asio2::detail
 
 	static constexpr std::size_t allocator_size = 1024;
 
+	/**
+	 * The recycling memory pool of the handlers, each thread has its own pool, so the allocation
+	 * needn't any lock. The memory blocks are divided into several size classes, the freed blocks
+	 * are cached in the free list of the size class of the current thread, and are reused by the
+	 * next allocation. The block which is freed by another thread is cached by that thread.
+	 * The hit count is the count of the allocations which are served by the cached memory, the
+	 * miss count is the count of the allocations which are served by the global heap.
+	 */
+	class handler_pool
+	{
+	public:
+		/// the min block size, the size classes are : 64 128 256 512 1024 2048 4096
+		static constexpr std::size_t min_block_size = 64;
+
+		/// the count of the size classes
+		static constexpr std::size_t class_count = 7;
+
+		/// the max count of the cached blocks of each size class
+		static constexpr std::size_t max_cached_count = 128;
+
+		handler_pool()
+		{
+			std::lock_guard<std::mutex> guard(handler_pool::mutex_);
+			this->next_ = handler_pool::pools_;
+			if (this->next_)
+				this->next_->prev_ = this;
+			handler_pool::pools_ = this;
+		}
+
+		~handler_pool()
+		{
+			for (std::size_t i = 0; i < class_count; ++i)
+			{
+				while (this->free_[i])
+				{
+					block_head* block = this->free_[i];
+					this->free_[i] = block->next;
+					::operator delete(static_cast<void*>(block));
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> guard(handler_pool::mutex_);
+				if (this->prev_)
+					this->prev_->next_ = this->next_;
+				else
+					handler_pool::pools_ = this->next_;
+				if (this->next_)
+					this->next_->prev_ = this->prev_;
+				handler_pool::retired_hits_   += this->hits_.load(std::memory_order_relaxed);
+				handler_pool::retired_misses_ += this->misses_.load(std::memory_order_relaxed);
+			}
+
+			handler_pool::destroyed_ = true;
+		}
+
+		handler_pool(const handler_pool&) = delete;
+		handler_pool& operator=(const handler_pool&) = delete;
+
+		/**
+		 * @function : get the pool of the current thread, return nullptr when the pool of the
+		 * current thread is destroyed already (when the thread is exiting).
+		 */
+		static inline handler_pool * this_thread_pool()
+		{
+			if (handler_pool::destroyed_)
+				return nullptr;
+			thread_local handler_pool pool;
+			return &pool;
+		}
+
+		static inline void * allocate(std::size_t size)
+		{
+			std::size_t index = handler_pool::_class_index(size);
+
+			handler_pool * pool = handler_pool::this_thread_pool();
+
+			if (pool && index < class_count && pool->free_[index])
+			{
+				block_head* block = pool->free_[index];
+				pool->free_[index] = block->next;
+				--(pool->count_[index]);
+				block->index = index;
+				pool->_hit();
+				return static_cast<void*>(reinterpret_cast<char*>(block) + head_size);
+			}
+
+			if (pool)
+				pool->_miss();
+
+			std::size_t bytes = index < class_count ? (min_block_size << index) : size;
+
+			block_head* block = static_cast<block_head*>(::operator new(head_size + bytes));
+			block->index = index;
+			return static_cast<void*>(reinterpret_cast<char*>(block) + head_size);
+		}
+
+		static inline void deallocate(void * pointer)
+		{
+			if (!pointer)
+				return;
+
+			block_head* block = reinterpret_cast<block_head*>(static_cast<char*>(pointer) - head_size);
+
+			std::size_t index = block->index;
+
+			handler_pool * pool = handler_pool::this_thread_pool();
+
+			if (pool && index < class_count && pool->count_[index] < max_cached_count)
+			{
+				block->next = pool->free_[index];
+				pool->free_[index] = block;
+				++(pool->count_[index]);
+				return;
+			}
+
+			::operator delete(static_cast<void*>(block));
+		}
+
+		/**
+		 * @function : count an allocation which is served by the memory outside the pool, eg : the
+		 * single slot of the handler_memory.
+		 */
+		static inline void count_hit()
+		{
+			handler_pool * pool = handler_pool::this_thread_pool();
+			if (pool)
+				pool->_hit();
+		}
+
+		/**
+		 * @function : get the total hit count of all threads
+		 */
+		static inline std::size_t hit_count()
+		{
+			std::lock_guard<std::mutex> guard(handler_pool::mutex_);
+			std::size_t count = handler_pool::retired_hits_;
+			for (handler_pool* pool = handler_pool::pools_; pool; pool = pool->next_)
+				count += pool->hits_.load(std::memory_order_relaxed);
+			return count;
+		}
+
+		/**
+		 * @function : get the total miss count of all threads
+		 */
+		static inline std::size_t miss_count()
+		{
+			std::lock_guard<std::mutex> guard(handler_pool::mutex_);
+			std::size_t count = handler_pool::retired_misses_;
+			for (handler_pool* pool = handler_pool::pools_; pool; pool = pool->next_)
+				count += pool->misses_.load(std::memory_order_relaxed);
+			return count;
+		}
+
+	protected:
+		union block_head
+		{
+			std::size_t      index;
+			block_head     * next;
+			std::max_align_t align;
+		};
+
+		static constexpr std::size_t head_size = sizeof(block_head);
+
+		static inline std::size_t _class_index(std::size_t size)
+		{
+			std::size_t index = 0;
+			for (std::size_t bytes = min_block_size; bytes < size && index < class_count; bytes <<= 1)
+				++index;
+			return index;
+		}
+
+		// only the owner thread modifies the counters, so needn't the atomic add.
+		inline void _hit () { this->hits_  .store(this->hits_  .load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+		inline void _miss() { this->misses_.store(this->misses_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+	protected:
+		block_head                * free_ [class_count] = {};
+
+		std::size_t                 count_[class_count] = {};
+
+		std::atomic<std::size_t>    hits_   { 0 };
+
+		std::atomic<std::size_t>    misses_ { 0 };
+
+		handler_pool              * prev_ = nullptr;
+
+		handler_pool              * next_ = nullptr;
+
+		static inline std::mutex    mutex_;
+
+		static inline handler_pool* pools_ = nullptr;
+
+		static inline std::size_t   retired_hits_   = 0;
+
+		static inline std::size_t   retired_misses_ = 0;
+
+		static inline thread_local bool destroyed_  = false;
+	};
+
 	template<std::size_t N = allocator_size>
 	struct size_op
 	{
@@ -51,7 +253,7 @@ namespace asio2::detail
 	// Class to manage the memory to be used for handler-based custom allocation.
 	// It contains a single block of memory which may be returned for allocation
 	// requests. If the memory is in use when an allocation request is made, the
-	// allocator delegates allocation to the global heap.
+	// allocator delegates allocation to the handler_pool of the current thread.
 	template<typename SizeN>
 	class handler_memory<SizeN, std::false_type>
 	{
@@ -64,14 +266,15 @@ namespace asio2::detail
 		inline void* allocate(std::size_t size)
 		{
 			//log_max_size(size);
-			if (!in_use_ && size < sizeof(storage_))
+			if (!in_use_ && size <= sizeof(storage_))
 			{
 				in_use_ = true;
+				handler_pool::count_hit();
 				return &storage_;
 			}
 			else
 			{
-				return ::operator new(size);
+				return handler_pool::allocate(size);
 			}
 		}
 
@@ -83,7 +286,7 @@ namespace asio2::detail
 			}
 			else
 			{
-				::operator delete(pointer);
+				handler_pool::deallocate(pointer);
 			}
 		}
 
@@ -107,13 +310,15 @@ namespace asio2::detail
 		inline void* allocate(std::size_t size)
 		{
 			//log_max_size(size);
-			if (!in_use_.test_and_set() && size < sizeof(storage_))
+			// check the size first, otherwise the flag is set but never cleared when the size is too large.
+			if (size <= sizeof(storage_) && !in_use_.test_and_set(std::memory_order_acquire))
 			{
+				handler_pool::count_hit();
 				return &storage_;
 			}
 			else
 			{
-				return ::operator new(size);
+				return handler_pool::allocate(size);
 			}
 		}
 
@@ -121,11 +326,11 @@ namespace asio2::detail
 		{
 			if (pointer == &storage_)
 			{
-				in_use_.clear();
+				in_use_.clear(std::memory_order_release);
 			}
 			else
 			{
-				::operator delete(pointer);
+				handler_pool::deallocate(pointer);
 			}
 		}
 
@@ -225,4 +430,9 @@ namespace asio2::detail
 
 }
 
+namespace asio2
+{
+	using handler_pool = detail::handler_pool;
+}
+
 #endif // !__ASIO2_ALLOCATOR_HPP__
@@ -24,7 +24,76 @@
 namespace asio2::detail
 {
 	struct use_sync_t {};
-	struct use_kcp_t {};
+	/**
+	 * The kcp options, see ikcp_nodelay ikcp_wndsize ikcp_setmtu of kcp.
+	 * the default value is the fast mode.
+	 */
+	struct kcp_option
+	{
+		int nodelay  = 1;    // 0 : disable, 1 : enable
+		int interval = 10;   // the interval of the internal update timer, unit : millisecond
+		int resend   = 2;    // the fast resend count, 0 : disable fast resend
+		int nc       = 1;    // 0 : normal congestion control, 1 : disable congestion control
+		int sndwnd   = 128;  // the send window size, unit : packet
+		int rcvwnd   = 512;  // the recv window size, unit : packet
+		int mtu      = 1400; // the max datagram size
+		int minrto   = 0;    // the min rto, unit : millisecond, 0 means the kcp default value
+
+		/**
+		 * @function : the kcp default mode, it's suitable for the bulk transfer.
+		 */
+		static constexpr kcp_option normal()
+		{
+			kcp_option opt;
+			opt.nodelay = 0; opt.interval = 40; opt.resend = 0; opt.nc = 0;
+			opt.sndwnd = 256; opt.rcvwnd = 256;
+			return opt;
+		}
+
+		/**
+		 * @function : the fast mode, it's suitable for the low latency transfer.
+		 */
+		static constexpr kcp_option fast()
+		{
+			return kcp_option{};
+		}
+	};
+
+	struct use_kcp_t
+	{
+		/// the data shards and parity shards of the forward error correction, 0 means no fec.
+		std::uint8_t fec_data_shards   = 0;
+		std::uint8_t fec_parity_shards = 0;
+
+		/// the initial options of the kcp
+		kcp_option   kcp_opt;
+
+		/**
+		 * @function : set the initial options of the kcp, it can be changed at runtime by the
+		 * kcp_option function of the session or client.
+		 * eg : server.start("0.0.0.0", 8080, asio2::use_kcp.option(asio2::kcp_option::normal()));
+		 */
+		constexpr use_kcp_t option(const kcp_option & opt) const
+		{
+			use_kcp_t c = *this;
+			c.kcp_opt = opt;
+			return c;
+		}
+
+		/**
+		 * @function : enable the reed-solomon forward error correction, the shards are negotiated
+		 * in the kcp handshake, the server accepts the shards which are requested by the client.
+		 * eg : server.start("0.0.0.0", 8080, asio2::use_kcp.fec(10, 3));
+		 * @param    : data_shards - 1 ~ 31, parity_shards - 1 ~ 31
+		 */
+		constexpr use_kcp_t fec(std::uint8_t data_shards, std::uint8_t parity_shards) const
+		{
+			use_kcp_t c = *this;
+			c.fec_data_shards   = (data_shards   > 31 ? std::uint8_t(31) : data_shards);
+			c.fec_parity_shards = (parity_shards > 31 ? std::uint8_t(31) : parity_shards);
+			return c;
+		}
+	};
 	struct use_dgram_t {};
 
 	namespace
@@ -182,14 +251,18 @@ namespace asio2::detail
 	{
 	public:
 		using type = use_kcp_t;
-		condition_wrap(use_kcp_t) {}
+		condition_wrap(use_kcp_t c) : kcp_(c) {}
 		inline asio::detail::transfer_at_least_t operator()() { return asio::transfer_at_least(1); }
+		inline const use_kcp_t & kcp() const { return this->kcp_; }
 	protected:
+		use_kcp_t kcp_;
 	};
 }
 
 namespace asio2
 {
+	using kcp_option = detail::kcp_option;
+
 	constexpr static detail::use_dgram_t use_dgram;
 
 	constexpr static detail::use_sync_t  use_sync;
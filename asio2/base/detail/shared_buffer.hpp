@@ -0,0 +1,184 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_SHARED_BUFFER_HPP__
+#define __ASIO2_SHARED_BUFFER_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <asio2/base/selector.hpp>
+
+#include <asio2/base/detail/util.hpp>
+
+namespace asio2::detail
+{
+	/// the max bytes of the dgram head
+	static std::size_t constexpr dgram_head_max_size = 9;
+
+	/**
+	 * make the dgram head of the data, the head buffer size must be dgram_head_max_size at least.
+	 * @return : the bytes of the head
+	 */
+	inline std::size_t make_dgram_head(std::size_t size, std::uint8_t * head)
+	{
+		// note : need ensure big endian and little endian
+		if (size < std::size_t(254))
+		{
+			head[0] = static_cast<std::uint8_t>(size);
+			return 1;
+		}
+		else if (size <= (std::numeric_limits<std::uint16_t>::max)())
+		{
+			head[0] = static_cast<std::uint8_t>(254);
+			std::uint16_t n = static_cast<std::uint16_t>(size);
+			std::memcpy(&head[1], reinterpret_cast<const void*>(&n), sizeof(std::uint16_t));
+			// use little endian
+			if (!is_little_endian())
+			{
+				swap_bytes<sizeof(std::uint16_t)>(&head[1]);
+			}
+			return 3;
+		}
+		else
+		{
+			ASIO2_ASSERT(size > (std::numeric_limits<std::uint16_t>::max)());
+			head[0] = static_cast<std::uint8_t>(255);
+			std::uint64_t n = size;
+			std::memcpy(&head[1], reinterpret_cast<const void*>(&n), sizeof(std::uint64_t));
+			// use little endian
+			if (!is_little_endian())
+			{
+				swap_bytes<sizeof(std::uint64_t)>(&head[1]);
+			}
+			return 9;
+		}
+	}
+
+	template<class, class = std::void_t<>>
+	struct is_shared_buffer_constructible : std::false_type {};
+
+	template<class T>
+	struct is_shared_buffer_constructible<T, std::void_t<decltype(asio::buffer(std::declval<const T&>()))>>
+		: std::true_type {};
+
+	/**
+	 * An immutable reference counted buffer, copying it only increases the reference count, so one
+	 * payload can be queued to many sessions without copying it for each session.
+	 * The dgram head is made in front of the payload when the buffer is created, so the dgram
+	 * sessions can write the head and the payload with one buffer directly.
+	 * It can be converted to asio::const_buffer, so it can be sent by all the sessions.
+	 */
+	class shared_buffer
+	{
+	public:
+		/**
+		 * @constructor
+		 */
+		shared_buffer() = default;
+
+		/**
+		 * @constructor
+		 */
+		shared_buffer(const void* data, std::size_t size)
+		{
+			std::shared_ptr<std::string> storage = std::make_shared<std::string>(dgram_head_max_size + size, '\0');
+
+			std::uint8_t head[dgram_head_max_size];
+
+			this->head_size_ = make_dgram_head(size, head);
+
+			char * p = storage->data();
+
+			std::memcpy(p + dgram_head_max_size - this->head_size_, head, this->head_size_);
+
+			if (size)
+				std::memcpy(p + dgram_head_max_size, data, size);
+
+			this->storage_ = std::move(storage);
+		}
+
+		/**
+		 * @constructor
+		 */
+		explicit shared_buffer(const asio::const_buffer& buffer) : shared_buffer(buffer.data(), buffer.size()) {}
+
+		/**
+		 * @constructor
+		 * supporting multi data formats,see asio::buffer(...) in /asio/buffer.hpp
+		 */
+		template<class T, std::enable_if_t<!std::is_same_v<std::decay_t<T>, shared_buffer> &&
+			!std::is_same_v<std::decay_t<T>, asio::const_buffer>, int> = 0>
+		explicit shared_buffer(const T& data) : shared_buffer(asio::const_buffer(asio::buffer(data))) {}
+
+		/**
+		 * @function : get the payload data pointer
+		 */
+		inline const void * data() const
+		{
+			return this->storage_ ? this->storage_->data() + dgram_head_max_size : nullptr;
+		}
+
+		/**
+		 * @function : get the payload size
+		 */
+		inline std::size_t size() const
+		{
+			return this->storage_ ? this->storage_->size() - dgram_head_max_size : 0;
+		}
+
+		/**
+		 * @function : get the payload buffer
+		 */
+		inline operator asio::const_buffer() const
+		{
+			return asio::const_buffer(this->data(), this->size());
+		}
+
+		/**
+		 * @function : get the bytes of the dgram head which is in front of the payload
+		 */
+		inline std::size_t dgram_head_size() const
+		{
+			return this->storage_ ? this->head_size_ : 0;
+		}
+
+		/**
+		 * @function : get the dgram head and the payload buffer
+		 */
+		inline asio::const_buffer dgram_buffer() const
+		{
+			if (!this->storage_)
+				return asio::const_buffer();
+			return asio::const_buffer(this->storage_->data() + dgram_head_max_size - this->head_size_,
+				this->head_size_ + this->size());
+		}
+
+	protected:
+		std::shared_ptr<const std::string> storage_;
+
+		std::size_t                        head_size_ = 0;
+	};
+}
+
+namespace asio2
+{
+	using shared_buffer = detail::shared_buffer;
+}
+
+#endif // !__ASIO2_SHARED_BUFFER_HPP__
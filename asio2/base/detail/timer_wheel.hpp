@@ -0,0 +1,427 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_TIMER_WHEEL_HPP__
+#define __ASIO2_TIMER_WHEEL_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#include <asio2/base/detail/allocator.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * The hierarchical timing wheel of an io_context, it is used by the session timers which are
+	 * numerous and are rarely fired, eg : silence timer, connect timeout timer. There are 4 levels
+	 * of 256 slots, the level 0 slot is a tick, the slot of each higher level is a full round of
+	 * the lower level, so starting and canceling a timer are O(1), and only one asio timer is used
+	 * to drive the wheel of an io_context. The timer is fired at the first tick which is not earlier
+	 * than its deadline, so it's fired up to a tick later.
+	 * All the functions must be called in the strand of the io.
+	 */
+	class timer_wheel
+	{
+	public:
+		/// the default duration of a tick
+		static constexpr std::chrono::milliseconds default_tick_duration = std::chrono::milliseconds(10);
+
+		static constexpr std::size_t level_bits  = 8;
+		static constexpr std::size_t slot_count  = std::size_t(1) << level_bits;
+		static constexpr std::size_t level_count = 4;
+
+	protected:
+		struct handler_base
+		{
+			virtual ~handler_base() = default;
+			virtual void invoke() = 0;
+		};
+
+		template<class Function>
+		struct handler_impl : public handler_base
+		{
+			explicit handler_impl(Function&& f) : fn(std::move(f)) {}
+			explicit handler_impl(const Function& f) : fn(f) {}
+			virtual void invoke() override { fn(); }
+			Function fn;
+		};
+
+		/// the timers are restarted frequently, so the handler is allocated from the handler pool
+		struct handler_deleter
+		{
+			inline void operator()(handler_base * p) const
+			{
+				p->~handler_base();
+				handler_pool::deallocate(static_cast<void*>(p));
+			}
+		};
+
+		using handler_ptr = std::unique_ptr<handler_base, handler_deleter>;
+
+		template<class Function>
+		static inline handler_ptr _make_handler(Function&& fn)
+		{
+			using impl_t = handler_impl<std::decay_t<Function>>;
+			void * p = handler_pool::allocate(sizeof(impl_t));
+			try
+			{
+				return handler_ptr(new (p) impl_t(std::forward<Function>(fn)));
+			}
+			catch (...)
+			{
+				handler_pool::deallocate(p);
+				throw;
+			}
+		}
+
+	public:
+		/**
+		 * The timer entry of the timing wheel, it's owned by the user, and is linked into the wheel
+		 * when it's started.
+		 */
+		class timer
+		{
+		public:
+			timer() = default;
+			~timer()
+			{
+				ASIO2_ASSERT(!this->linked_);
+			}
+
+			timer(const timer&) = delete;
+			timer& operator=(const timer&) = delete;
+
+			/**
+			 * @function : check whether the timer is waiting in the wheel
+			 */
+			inline bool is_pending() const { return this->linked_; }
+
+		protected:
+			friend class timer_wheel;
+
+			timer                 * prev_   = nullptr;
+			timer                 * next_   = nullptr;
+			std::uint64_t           expire_ = 0;
+			std::uint8_t            level_  = 0;
+			std::uint8_t            slot_   = 0;
+			bool                    linked_ = false;
+			handler_ptr             handler_;
+		};
+
+	public:
+		/**
+		 * @constructor
+		 */
+		timer_wheel(asio::io_context & ioc, asio::io_context::strand & strand,
+			std::chrono::milliseconds tick = default_tick_duration)
+			: strand_(strand)
+			, driver_(ioc)
+			, tick_((std::max)(tick, std::chrono::milliseconds(1)))
+			, base_(std::chrono::steady_clock::now())
+		{
+			for (auto & slots : this->slots_)
+				slots.fill(nullptr);
+		}
+
+		/**
+		 * @destructor
+		 */
+		~timer_wheel() = default;
+
+		timer_wheel(const timer_wheel&) = delete;
+		timer_wheel& operator=(const timer_wheel&) = delete;
+
+		/**
+		 * @function : start the timer, if the timer is pending already, it's restarted.
+		 * Function signature : void()
+		 */
+		template<class Rep, class Period, class Function>
+		inline void start(timer & t, std::chrono::duration<Rep, Period> duration, Function&& fn)
+		{
+			ASIO2_ASSERT(this->strand_.running_in_this_thread());
+
+			// the old handler may hold the owner of the timer, destroy it at the end.
+			handler_ptr old = std::move(t.handler_);
+
+			if (t.linked_)
+			{
+				this->_unlink(t);
+				--(this->count_);
+			}
+
+			// the io is shutting down, the timer is never fired.
+			if (this->stopped_)
+				return;
+
+			// the wheel is idle, so it's empty, move it to the current time directly.
+			if (!this->driving_)
+				this->now_ = this->_clock_tick();
+
+			// the first tick which is not earlier than the deadline
+			auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - this->base_) + std::chrono::duration_cast<
+				std::chrono::nanoseconds>((std::max)(duration, std::chrono::duration<Rep, Period>::zero()));
+			std::uint64_t expire = static_cast<std::uint64_t>((deadline + this->tick_ -
+				std::chrono::nanoseconds(1)) / this->tick_);
+
+			t.expire_  = (std::max<std::uint64_t>)(expire, this->now_ + 1);
+			t.handler_ = _make_handler(std::forward<Function>(fn));
+
+			this->_link(t);
+			++(this->count_);
+
+			if (!this->driving_)
+				this->_drive();
+		}
+
+		/**
+		 * @function : cancel the timer, the handler is destroyed without being called.
+		 */
+		inline void cancel(timer & t)
+		{
+			ASIO2_ASSERT(this->strand_.running_in_this_thread());
+
+			// the handler may hold the owner of the timer, destroy it at the end.
+			handler_ptr handler = std::move(t.handler_);
+
+			if (t.linked_)
+			{
+				this->_unlink(t);
+				--(this->count_);
+			}
+		}
+
+		/**
+		 * @function : stop the wheel when the io is shutting down, the driver is canceled and all
+		 * the pending timers are unlinked, their handlers are destroyed without being called, and
+		 * the timers which are started after this are never fired, so the io_context can run out
+		 * of work.
+		 */
+		inline void stop()
+		{
+			ASIO2_ASSERT(this->strand_.running_in_this_thread());
+
+			this->stopped_ = true;
+
+			// the handlers may hold the owners of the timers, destroy them at the end.
+			std::vector<handler_ptr> handlers;
+
+			for (auto & slots : this->slots_)
+			{
+				for (timer *& head : slots)
+				{
+					while (timer * t = head)
+					{
+						this->_unlink(*t);
+						handlers.emplace_back(std::move(t->handler_));
+					}
+				}
+			}
+
+			this->count_ = 0;
+
+			try
+			{
+				this->driver_.cancel();
+			}
+			catch (system_error &) {}
+		}
+
+		/**
+		 * @function : make the wheel usable again after it's stopped, it must be called when the
+		 * io_context is not running, eg : before the iopool is started again.
+		 */
+		inline void restart()
+		{
+			ASIO2_ASSERT(this->count_ == 0);
+
+			this->stopped_ = false;
+		}
+
+		/**
+		 * @function : get the duration of a tick
+		 */
+		inline std::chrono::nanoseconds tick_duration() const
+		{
+			return this->tick_;
+		}
+
+		/**
+		 * @function : get the count of the pending timers
+		 */
+		inline std::size_t size() const
+		{
+			return this->count_;
+		}
+
+	protected:
+		inline std::uint64_t _clock_tick() const
+		{
+			return static_cast<std::uint64_t>((std::chrono::steady_clock::now() - this->base_) / this->tick_);
+		}
+
+		inline void _link(timer & t)
+		{
+			// the timer which is expired already is linked into the current slot of level 0, it's
+			// only happened when cascading, and the current slot is fired after cascading.
+			std::uint64_t delta = t.expire_ > this->now_ ? t.expire_ - this->now_ : 0;
+
+			// the expire time is beyond the max level, link it into the last slot of the max level,
+			// it's relinked when the slot is cascaded.
+			std::uint64_t expire = t.expire_ > this->now_ ? t.expire_ : this->now_;
+			if (delta >= (std::uint64_t(1) << (level_bits * level_count)))
+				expire = this->now_ + (std::uint64_t(1) << (level_bits * level_count)) - 1;
+
+			std::size_t level = 0;
+			while (level < level_count - 1 && delta >= (std::uint64_t(1) << (level_bits * (level + 1))))
+				++level;
+
+			std::size_t slot = static_cast<std::size_t>((expire >> (level_bits * level)) & (slot_count - 1));
+
+			timer *& head = this->slots_[level][slot];
+
+			t.level_  = static_cast<std::uint8_t>(level);
+			t.slot_   = static_cast<std::uint8_t>(slot);
+			t.prev_   = nullptr;
+			t.next_   = head;
+			t.linked_ = true;
+
+			if (head)
+				head->prev_ = &t;
+			head = &t;
+		}
+
+		inline void _unlink(timer & t)
+		{
+			if (t.prev_)
+				t.prev_->next_ = t.next_;
+			else
+				this->slots_[t.level_][t.slot_] = t.next_;
+
+			if (t.next_)
+				t.next_->prev_ = t.prev_;
+
+			t.prev_   = nullptr;
+			t.next_   = nullptr;
+			t.linked_ = false;
+		}
+
+		inline void _cascade(std::size_t level, std::size_t slot)
+		{
+			timer * t = this->slots_[level][slot];
+			this->slots_[level][slot] = nullptr;
+			while (t)
+			{
+				timer * next = t->next_;
+				this->_link(*t);
+				t = next;
+			}
+		}
+
+		inline void _advance()
+		{
+			++(this->now_);
+
+			std::size_t slot = static_cast<std::size_t>(this->now_ & (slot_count - 1));
+
+			// a round of the lower level is finished, move the timers of the next slot of the
+			// higher level to the lower levels.
+			if (slot == 0)
+			{
+				for (std::size_t level = 1; level < level_count; ++level)
+				{
+					std::size_t index = static_cast<std::size_t>(
+						(this->now_ >> (level_bits * level)) & (slot_count - 1));
+					this->_cascade(level, index);
+					if (index != 0)
+						break;
+				}
+			}
+
+			// the handler may start or cancel the other timers, so take the timer one by one.
+			while (timer * t = this->slots_[0][slot])
+			{
+				this->_unlink(*t);
+				--(this->count_);
+
+				handler_ptr handler = std::move(t->handler_);
+
+				if (handler)
+					handler->invoke();
+			}
+		}
+
+		inline void _drive()
+		{
+			this->driving_ = true;
+
+			this->driver_.expires_at(this->base_ + this->tick_ * (this->now_ + 1));
+			this->driver_.async_wait(asio::bind_executor(this->strand_, [this](const error_code & ec)
+			{
+				if (ec == asio::error::operation_aborted)
+				{
+					this->driving_ = false;
+					return;
+				}
+
+				std::uint64_t now = this->_clock_tick();
+				while (this->now_ < now && this->count_ > 0)
+				{
+					this->_advance();
+				}
+
+				// stop driving when there are no timers, otherwise the io_context never runs out of work.
+				if (this->count_ > 0)
+					this->_drive();
+				else
+					this->driving_ = false;
+			}));
+		}
+
+	protected:
+		asio::io_context::strand                                   & strand_;
+
+		/// the asio timer which drives the wheel
+		asio::steady_timer                                           driver_;
+
+		/// the duration of a tick
+		std::chrono::nanoseconds                                     tick_;
+
+		/// the time of the tick 0
+		std::chrono::steady_clock::time_point                        base_;
+
+		/// the current tick
+		std::uint64_t                                                now_ = 0;
+
+		/// the count of the pending timers
+		std::size_t                                                  count_ = 0;
+
+		bool                                                         driving_ = false;
+
+		bool                                                         stopped_ = false;
+
+		std::array<std::array<timer*, slot_count>, level_count>      slots_;
+	};
+}
+
+#endif // !__ASIO2_TIMER_WHEEL_HPP__
@@ -319,6 +319,15 @@ namespace asio2::detail
 		}
 	}
 
+#if defined(SO_REUSEPORT)
+	/**
+	 * Implements the SOL_SOCKET/SO_REUSEPORT socket option, asio does not provide it.
+	 * Multiple sockets bound to the same address and port, the kernel distributes the
+	 * incoming connections or datagrams across them.
+	 */
+	using socket_reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
 	// Returns true if the current machine is little endian
 	inline bool is_little_endian()
 	{
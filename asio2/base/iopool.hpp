@@ -19,24 +19,37 @@
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <future>
 #include <type_traits>
 
 #include <asio2/base/selector.hpp>
 
+#include <asio2/base/detail/timer_wheel.hpp>
+
 namespace asio2::detail
 {
 	class io_t
 	{
 	public:
-		io_t() : context_(1), strand_(context_) {}
+		io_t()
+			: context_(1), strand_(context_), wheel_(context_, strand_)
+			, kcp_wheel_(context_, strand_, std::chrono::milliseconds(1)) {}
 		~io_t() = default;
 
 		inline asio::io_context & context() { return this->context_; }
 		inline asio::io_context::strand &  strand() { return this->strand_; }
+		inline timer_wheel              &  wheel()  { return this->wheel_;  }
+
+		/// the kcp interval is usually 10ms or less, so the kcp sessions use a wheel of 1ms tick
+		inline timer_wheel              &  kcp_wheel() { return this->kcp_wheel_; }
 
 	protected:
 		asio::io_context context_;
 		asio::io_context::strand strand_;
+		timer_wheel wheel_;
+		timer_wheel kcp_wheel_;
 	};
 
 	/**
@@ -93,6 +106,9 @@ namespace asio2::detail
 				 */
 				io.context().restart();
 
+				io.wheel().restart();
+				io.kcp_wheel().restart();
+
 				this->works_.emplace_back(io.context().get_executor());
 
 				// start work thread
@@ -135,6 +151,17 @@ namespace asio2::detail
 				this->stopped_ = true;
 			}
 
+			// The pending timers of the wheels keep the io_context from running out of work, so
+			// stop the wheels after the events which are posted already.
+			for (auto & io : this->ios_)
+			{
+				asio::post(io.strand(), [&io]()
+				{
+					io.wheel().stop();
+					io.kcp_wheel().stop();
+				});
+			}
+
 			// Waiting for all nested events to complete.
 			// The mutex_ must be released while waiting, otherwise, the stop function may be called
 			// in the communication thread and the lock will be requested, which is already held here,
@@ -183,7 +210,23 @@ namespace asio2::detail
 		inline io_t & get(std::size_t index = static_cast<std::size_t>(-1))
 		{
 			// Use a round-robin scheme to choose the next io_context to use. 
-			return this->ios_[index < this->ios_.size() ? index : ((++(this->next_)) % this->ios_.size())];
+			return this->ios_[index < this->ios_.size() ? index : this->next()];
+		}
+
+		/**
+		 * @function : get the index of the next io_context to use, use a round-robin scheme.
+		 */
+		inline std::size_t next()
+		{
+			return ((++(this->next_)) % this->ios_.size());
+		}
+
+		/**
+		 * @function : get the io_context pool size
+		 */
+		inline std::size_t size() const
+		{
+			return this->ios_.size();
 		}
 
 		/**
@@ -266,11 +309,12 @@ namespace asio2::detail
 		/// 
 		std::mutex                     mutex_;
 
-		/// Flag whether the io_context pool has stopped already
-		bool                           stopped_  = true;
+		/// Flag whether the io_context pool has stopped already, it's read in any thread
+		std::atomic<bool>              stopped_  = true;
 
 		/// The next io_context to use for a connection. 
-		std::size_t                    next_     = 0;
+		/// the pool may be shared by many objects which are created in different threads.
+		std::atomic<std::size_t>       next_     = 0;
 
 		// Give all the io_contexts work to do so that their run() functions will not 
 		// exit until they are explicitly stopped. 
@@ -280,13 +324,123 @@ namespace asio2::detail
 	class iopool_cp
 	{
 	public:
-		iopool_cp(std::size_t concurrency) : iopool_(concurrency) {}
-		~iopool_cp() = default;
+		/**
+		 * @constructor
+		 * @param    : concurrency - the size of the io_context pool which is owned by this object
+		 */
+		explicit iopool_cp(std::size_t concurrency)
+			: iopool_ptr_(std::make_unique<iopool>(concurrency))
+			, iopool_(*iopool_ptr_)
+			, iopool_index_(0)
+		{
+		}
+
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool, it can be shared by many objects,
+		 * the io_context used by this object is selected from the pool by round-robin scheme.
+		 * the pool must outlive this object, and it is never stopped by this object.
+		 */
+		explicit iopool_cp(iopool & pool)
+			: iopool_ptr_()
+			, iopool_(pool)
+			, iopool_index_(pool.next())
+		{
+		}
+
+		~iopool_cp()
+		{
+			// the owned pool is destroyed in one of its threads, eg : the object is destroyed in its
+			// callback, the thread can't join itself, so the pool is stopped and destroyed in another
+			// thread after the current handler returns.
+			if (this->iopool_ptr_ && this->iopool_ptr_->running_in_iopool_threads())
+			{
+				std::thread([pool = std::move(this->iopool_ptr_)]() mutable
+				{
+					pool->stop();
+					pool.reset();
+				}).detach();
+			}
+		}
+
+		/**
+		 * @function : get the io_context pool refrence
+		 */
+		inline iopool & get_iopool() { return this->iopool_; }
+
+		/**
+		 * @function : check whether the io_context pool is supplied by the user
+		 */
+		inline bool is_user_iopool() const { return (!this->iopool_ptr_); }
+
+	protected:
+		/**
+		 * @function : stop the io_context pool if it's owned by this object, otherwise the pool is
+		 * shared with others and can't be stopped here, so we wait until the io_context has invoked
+		 * all the events of this object, this object can be destroyed safely after that.
+		 * @param    : io - the io which this object is running on
+		 * @param    : stopped - function signature : bool(), check whether this object is stopped
+		 */
+		template<class Function>
+		inline void _stop_iopool(io_t & io, Function&& stopped)
+		{
+			if (this->iopool_ptr_)
+			{
+				this->iopool_.stop();
+				return;
+			}
+
+			// if we are in the thread of the io, we can't wait here, otherwise it will cause dead lock.
+			// the other threads of the pool can wait for the io.
+			if (this->iopool_.is_stopped() || io.context().get_executor().running_in_this_thread())
+				return;
+
+			// The closed socket and canceled timers post their handlers to the io_context, so we
+			// post a event to the io_context first, then the event is posted to the strand from
+			// there, when it is invoked, all the handlers which were posted before have completed.
+			auto barrier = [&io]()
+			{
+				std::promise<void> promise;
+				std::future<void> future = promise.get_future();
+				asio::post(io.context(), [&io, &promise]()
+				{
+					asio::post(io.strand(), [&promise]()
+					{
+						promise.set_value();
+					});
+				});
+				future.wait();
+			};
+
+			// each barrier completes a level of the nested posted events, the stop of this object
+			// needs only a few levels, so don't wait forever if it's never stopped.
+			auto deadline = std::chrono::steady_clock::now() + max_stop_wait;
+			do
+			{
+				barrier();
+			} while (!stopped() && this->iopool_.is_started() && std::chrono::steady_clock::now() < deadline);
+
+			barrier();
+		}
 
 	protected:
+		/// the max time to wait for the stop of this object
+		static constexpr std::chrono::milliseconds max_stop_wait = std::chrono::milliseconds(3000);
+
+		/// the io_context pool which is owned by this object, empty if the pool is supplied by the user
+		std::unique_ptr<iopool> iopool_ptr_;
+
 		/// the io_context pool for socket event
-		iopool iopool_;
+		iopool                & iopool_;
+
+		/// the index of the io_context in the pool which is used by this object
+		std::size_t             iopool_index_ = 0;
 	};
 }
 
+namespace asio2
+{
+	using iopool = detail::iopool;
+}
+
 #endif // !__ASIO2_IOPOOL_HPP__
@@ -45,6 +45,8 @@ namespace asio2::detail
 		init,
 		start,
 		stop,
+		mcast_recv,
+		mcast_gap,
 		//send,
 		max
 	};
@@ -36,6 +36,7 @@
 #include <asio2/base/detail/allocator.hpp>
 #include <asio2/base/detail/util.hpp>
 #include <asio2/base/detail/buffer_wrap.hpp>
+#include <asio2/base/detail/shared_buffer.hpp>
 
 #include <asio2/base/component/user_data_cp.hpp>
 #include <asio2/base/component/user_timer_cp.hpp>
@@ -130,14 +131,29 @@ namespace asio2::detail
 		 * std::array<PodType, N> : std::array<int,10> m; send(m);
 		 * std::vector<PodType, Allocator> : std::vector<float> m; send(m);
 		 * std::basic_string<Elem, Traits, Allocator> : std::string m; send(m);
+		 * The data is copied into one shared_buffer, and all the sessions reference it, so the data
+		 * is not copied for each session. You can also pass a shared_buffer directly.
 		 */
 		template<class T>
 		inline derived_t & send(const T& data)
 		{
-			this->sessions_.foreach([&data](std::shared_ptr<session_t>& session_ptr) mutable
+			if constexpr (is_shared_buffer_constructible<T>::value)
 			{
-				session_ptr->send(data);
-			});
+				if constexpr (std::is_same_v<T, shared_buffer>)
+					this->derived()._broadcast(data);
+				else
+					this->derived()._broadcast(shared_buffer(data));
+			}
+			else
+			{
+				this->derived()._foreach_session_mgr([&data](session_mgr_t<session_t> & sessions)
+				{
+					sessions.foreach([&data](std::shared_ptr<session_t>& session_ptr) mutable
+					{
+						session_ptr->send(data);
+					});
+				});
+			}
 			return this->derived();
 		}
 
@@ -173,14 +189,27 @@ namespace asio2::detail
 		{
 			if (s)
 			{
-				this->sessions_.foreach([s, count](std::shared_ptr<session_t>& session_ptr)
-				{
-					session_ptr->send(s, count);
-				});
+				this->derived()._broadcast(shared_buffer(reinterpret_cast<const void*>(s),
+					static_cast<std::size_t>(count) * sizeof(CharT)));
 			}
 			return this->derived();
 		}
 
+	protected:
+		/**
+		 * @function : send the shared buffer to each session, the sessions only hold a reference of it.
+		 */
+		inline void _broadcast(const shared_buffer& buffer)
+		{
+			this->derived()._foreach_session_mgr([&buffer](session_mgr_t<session_t> & sessions)
+			{
+				sessions.foreach([&buffer](std::shared_ptr<session_t>& session_ptr)
+				{
+					session_ptr->send(buffer);
+				});
+			});
+		}
+
 	public:
 		/**
 		 * @function : get the acceptor refrence,derived classes must override this function
@@ -217,7 +246,15 @@ namespace asio2::detail
 		/**
 		 * @function : get connected session count
 		 */
-		inline std::size_t session_count() { return this->sessions_.size(); }
+		inline std::size_t session_count()
+		{
+			std::size_t count = 0;
+			this->derived()._foreach_session_mgr([&count](session_mgr_t<session_t> & sessions)
+			{
+				count += sessions.size();
+			});
+			return count;
+		}
 
 		/**
 		 * @function :
@@ -227,7 +264,10 @@ namespace asio2::detail
 		 */
 		inline derived_t & foreach_session(const std::function<void(std::shared_ptr<session_t>&)> & fn)
 		{
-			this->sessions_.foreach(fn);
+			this->derived()._foreach_session_mgr([&fn](session_mgr_t<session_t> & sessions)
+			{
+				sessions.foreach(fn);
+			});
 			return this->derived();
 		}
 
@@ -240,7 +280,13 @@ namespace asio2::detail
 		 */
 		inline std::shared_ptr<session_t> find_session_if(const std::function<bool(std::shared_ptr<session_t>&)> & fn)
 		{
-			return std::shared_ptr<session_t>(this->sessions_.find_if(fn));
+			std::shared_ptr<session_t> session_ptr;
+			this->derived()._foreach_session_mgr([&fn, &session_ptr](session_mgr_t<session_t> & sessions)
+			{
+				if (!session_ptr)
+					session_ptr = sessions.find_if(fn);
+			});
+			return session_ptr;
 		}
 
 		/**
@@ -259,6 +305,17 @@ namespace asio2::detail
 		inline auto & wallocator() { return this->wallocator_; }
 
 		inline session_mgr_t<session_t> & sessions() { return this->sessions_; }
+
+		/**
+		 * @function : call the function for each session manager of this server, the derived class
+		 * which has more than one session manager must override this function, eg : udp_server.
+		 * Function signature : void(session_mgr_t<session_t> & sessions)
+		 */
+		template<class Function>
+		inline void _foreach_session_mgr(Function&& fn)
+		{
+			fn(this->sessions_);
+		}
 		inline listener_t               & listener() { return this->listener_; }
 		inline std::atomic<state_t>     & state()    { return this->state_;    }
 		inline std::shared_ptr<derived_t> selfptr()  { return std::shared_ptr<derived_t>{}; }
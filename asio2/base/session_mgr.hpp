@@ -15,12 +15,17 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstdint>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
 #include <memory>
 #include <functional>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include <asio2/base/selector.hpp>
 #include <asio2/base/iopool.hpp>
@@ -31,6 +36,12 @@ namespace asio2::detail
 {
 	/**
 	 * the session manager interface
+	 * The sessions are divided into several shards by the hash of the session key, each shard has
+	 * its own lock, so the finding, inserting and erasing of different shards don't block each other.
+	 * The foreach and find_if iterate a snapshot of each shard, and the user callback is called
+	 * without holding any lock, so a long foreach (eg : broadcast) never blocks accept/disconnect.
+	 * The snapshot is changed in place by the emplace and erase, it's copied only when it's being
+	 * iterated, so the broadcasts don't rebuild it after each accept/disconnect.
 	 */
 	template<class session_t>
 	class session_mgr_t
@@ -39,12 +50,14 @@ namespace asio2::detail
 		using self = session_mgr_t<session_t>;
 		using key_type = typename session_t::key_type;
 
+		/// the count of the shards, must be power of 2
+		static constexpr std::size_t shard_count = 16;
+
 		/**
 		 * @constructor
 		 */
 		explicit session_mgr_t(io_t & acceptor_io) : io_(acceptor_io)
 		{
-			this->sessions_.reserve(64);
 		}
 
 		/**
@@ -60,6 +73,8 @@ namespace asio2::detail
 			if (!session_ptr)
 				return;
 
+			// the callback is called on the acceptor strand, so the notifications of the sessions
+			// are serialized, as before.
 			if (!this->io_.strand().running_in_this_thread())
 				return asio::post(this->io_.strand(), make_allocator(this->allocator_,
 					std::bind(&self::emplace, this, std::move(session_ptr), std::move(callback))));
@@ -67,9 +82,18 @@ namespace asio2::detail
 			bool inserted = false;
 
 			{
-				std::unique_lock<std::shared_mutex> guard(this->mutex_);
-				inserted = this->sessions_.try_emplace(session_ptr->hash_key(), session_ptr).second;
+				shard_t & shard = this->_shard(session_ptr->hash_key());
+				std::unique_lock<std::shared_mutex> guard(shard.mutex);
+				inserted = shard.sessions.try_emplace(session_ptr->hash_key(), session_ptr).second;
 				session_ptr->in_sessions = inserted;
+				if (inserted)
+				{
+					this->_update_snapshot(shard, [&session_ptr](sessions_t & sessions)
+					{
+						sessions.emplace_back(session_ptr);
+					});
+					this->size_.fetch_add(1, std::memory_order_relaxed);
+				}
 			}
 
 			(callback)(inserted);
@@ -89,10 +113,25 @@ namespace asio2::detail
 
 			bool erased = false;
 
+			if (session_ptr->in_sessions)
 			{
-				std::unique_lock<std::shared_mutex> guard(this->mutex_);
-				if (session_ptr->in_sessions)
-					erased = (this->sessions_.erase(session_ptr->hash_key()) > 0);
+				shard_t & shard = this->_shard(session_ptr->hash_key());
+				std::unique_lock<std::shared_mutex> guard(shard.mutex);
+				erased = (shard.sessions.erase(session_ptr->hash_key()) > 0);
+				if (erased)
+				{
+					// the erased session mustn't be held by the snapshot.
+					this->_update_snapshot(shard, [&session_ptr](sessions_t & sessions)
+					{
+						auto iter = std::find(sessions.begin(), sessions.end(), session_ptr);
+						if (iter != sessions.end())
+						{
+							*iter = std::move(sessions.back());
+							sessions.pop_back();
+						}
+					});
+					this->size_.fetch_sub(1, std::memory_order_relaxed);
+				}
 			}
 
 			(callback)(erased);
@@ -110,14 +149,17 @@ namespace asio2::detail
 		 * @function : call user custom callback function for every session
 		 * the custom callback function is like this :
 		 * void on_callback(std::shared_ptr<tcp_session> & session_ptr)
+		 * The sessions which are inserted or erased during the iteration may be visited or not.
 		 */
 		inline void foreach(const std::function<void(std::shared_ptr<session_t> &)> & fn)
 		{
-			std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			for (auto &[k, session_ptr] : this->sessions_)
+			for (shard_t & shard : this->shards_)
 			{
-				std::ignore = k;
-				fn(session_ptr);
+				snapshot_ptr snapshot = this->_snapshot(shard);
+				for (std::shared_ptr<session_t> & session_ptr : *snapshot)
+				{
+					fn(session_ptr);
+				}
 			}
 		}
 
@@ -126,9 +168,10 @@ namespace asio2::detail
 		 */
 		inline std::shared_ptr<session_t> find(const key_type & key)
 		{
-			std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			auto iter = this->sessions_.find(key);
-			return (iter == this->sessions_.end() ? std::shared_ptr<session_t>() : iter->second);
+			shard_t & shard = this->_shard(key);
+			std::shared_lock<std::shared_mutex> guard(shard.mutex);
+			auto iter = shard.sessions.find(key);
+			return (iter == shard.sessions.end() ? std::shared_ptr<session_t>() : iter->second);
 		}
 
 		/**
@@ -136,13 +179,16 @@ namespace asio2::detail
 		 */
 		inline std::shared_ptr<session_t> find_if(const std::function<bool(std::shared_ptr<session_t> &)> & fn)
 		{
-			std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			auto iter = std::find_if(this->sessions_.begin(), this->sessions_.end(),
-				[this, &fn](auto &pair)
+			for (shard_t & shard : this->shards_)
 			{
-				return fn(pair.second);
-			});
-			return (iter == this->sessions_.end() ? std::shared_ptr<session_t>() : iter->second);
+				snapshot_ptr snapshot = this->_snapshot(shard);
+				for (std::shared_ptr<session_t> & session_ptr : *snapshot)
+				{
+					if (fn(session_ptr))
+						return session_ptr;
+				}
+			}
+			return std::shared_ptr<session_t>();
 		}
 
 		/**
@@ -150,7 +196,7 @@ namespace asio2::detail
 		 */
 		inline std::size_t size()
 		{
-			return this->sessions_.size();
+			return this->size_.load(std::memory_order_relaxed);
 		}
 
 		/**
@@ -158,15 +204,90 @@ namespace asio2::detail
 		 */
 		inline bool empty()
 		{
-			return this->sessions_.empty();
+			return (this->size() == 0);
+		}
+
+	protected:
+		using sessions_t   = std::vector<std::shared_ptr<session_t>>;
+		using snapshot_ptr = std::shared_ptr<sessions_t>;
+
+		struct shard_t
+		{
+			/// session unorder map,these session is already connected session
+			std::unordered_map<key_type, std::shared_ptr<session_t>> sessions;
+
+			/// use rwlock to make this session map thread safe
+			std::shared_mutex mutex;
+
+			/// the copy of the sessions for iteration, it's built by the first iteration, and then
+			/// it's changed with the sessions.
+			snapshot_ptr      snapshot;
+		};
+
+		inline shard_t & _shard(const key_type & key)
+		{
+			// the hash of the pointer key is the address, the low bits are always zero, so mix it.
+			std::uint64_t h = static_cast<std::uint64_t>(std::hash<key_type>()(key));
+			h = (h ^ (h >> 32)) * std::uint64_t(0x9E3779B97F4A7C15);
+			return this->shards_[static_cast<std::size_t>(h >> 32) & (shard_count - 1)];
+		}
+
+		/**
+		 * the snapshot is only copied out under the shared lock, so when the writer which holds the
+		 * unique lock sees that the shard has the only reference of it, no one is iterating it.
+		 */
+		inline snapshot_ptr _snapshot(shard_t & shard)
+		{
+			std::shared_lock<std::shared_mutex> guard(shard.mutex);
+
+			snapshot_ptr snapshot = std::atomic_load(&shard.snapshot);
+			if (snapshot)
+				return snapshot;
+
+			// the readers may build it at the same time, they build the same content.
+			snapshot = std::make_shared<sessions_t>();
+			snapshot->reserve(shard.sessions.size());
+			for (auto &[k, session_ptr] : shard.sessions)
+			{
+				std::ignore = k;
+				snapshot->emplace_back(session_ptr);
+			}
+
+			std::atomic_store(&shard.snapshot, snapshot);
+			return snapshot;
+		}
+
+		/**
+		 * change the snapshot with the sessions, it must be called under the unique lock. It's
+		 * changed in place if no one is iterating it, otherwise it's copied on write.
+		 */
+		template<class Function>
+		inline void _update_snapshot(shard_t & shard, Function&& fn)
+		{
+			snapshot_ptr snapshot = std::atomic_load(&shard.snapshot);
+			if (!snapshot)
+				return;
+
+			// the local copy and the shard
+			if (snapshot.use_count() == 2)
+			{
+				// pairs with the release of the reference by the last reader
+				std::atomic_thread_fence(std::memory_order_acquire);
+				fn(*snapshot);
+				return;
+			}
+
+			snapshot = std::make_shared<sessions_t>(*snapshot);
+			fn(*snapshot);
+			std::atomic_store(&shard.snapshot, std::move(snapshot));
 		}
 
 	protected:
-		/// session unorder map,these session is already connected session 
-		std::unordered_map<key_type, std::shared_ptr<session_t>> sessions_;
+		/// the session shards
+		std::array<shard_t, shard_count> shards_;
 
-		/// use rwlock to make this session map thread safe
-		std::shared_mutex mutex_;
+		/// the total session count
+		std::atomic<std::size_t> size_{ 0 };
 
 		io_t & io_;
 
@@ -67,6 +67,21 @@ namespace asio2::detail
 		{
 		}
 
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many clients
+		 */
+		explicit ws_client_impl_t(
+			iopool & pool,
+			std::size_t init_buffer_size = tcp_frame_size,
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: super(pool, init_buffer_size, max_buffer_size)
+			, ws_stream_comp()
+			, ws_send_op<derived_t, false>()
+		{
+		}
+
 		/**
 		 * @destructor
 		 */
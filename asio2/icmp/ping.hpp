@@ -93,15 +93,41 @@ namespace asio2::detail
 			: super()
 			, iopool_cp(1)
 			, user_data_cp<derived_t>()
-			, user_timer_cp<derived_t, false>(iopool_.get(0))
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
 			, post_cp<derived_t>()
-			, socket_(iopool_.get(0).context())
+			, socket_(iopool_.get(iopool_index_).context())
 			, rallocator_()
 			, wallocator_()
 			, listener_()
-			, io_(iopool_.get(0))
+			, io_(iopool_.get(iopool_index_))
 			, buffer_(init_buffer_size, max_buffer_size)
-			, timer_(iopool_.get(0).context())
+			, timer_(iopool_.get(iopool_index_).context())
+			, ncount_(send_count)
+		{
+		}
+
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many objects
+		 */
+		explicit ping_impl_t(
+			iopool & pool,
+			std::size_t send_count = -1,
+			std::size_t init_buffer_size = 64 * 1024, // We prepare the buffer to receive up to 64KB.
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: super()
+			, iopool_cp(pool)
+			, user_data_cp<derived_t>()
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, post_cp<derived_t>()
+			, socket_(iopool_.get(iopool_index_).context())
+			, rallocator_()
+			, wallocator_()
+			, listener_()
+			, io_(iopool_.get(iopool_index_))
+			, buffer_(init_buffer_size, max_buffer_size)
+			, timer_(iopool_.get(iopool_index_).context())
 			, ncount_(send_count)
 		{
 		}
@@ -131,7 +157,7 @@ namespace asio2::detail
 		{
 			this->derived()._do_stop(asio::error::operation_aborted);
 
-			this->iopool_.stop();
+			this->_stop_iopool(this->io_, [this]() { return this->derived().is_stopped(); });
 		}
 
 		/**
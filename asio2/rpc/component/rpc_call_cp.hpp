@@ -80,6 +80,24 @@ namespace asio2::detail
 		 */
 		~rpc_call_cp() = default;
 
+	public:
+		/**
+		 * @function : set whether the function is called by the method id of the name, the method id
+		 * is the 4 bytes hash of the name, it makes the request smaller and is looked up faster by the
+		 * peer. Only enable it if the peer supports the call by id, the peer of the old version can not
+		 * parse the request which has the method id. The default is false.
+		 */
+		inline derived_t & call_by_id(bool enable)
+		{
+			this->call_by_id_ = enable;
+			return (this->derive);
+		}
+
+		/**
+		 * @function : check whether the function is called by the method id of the name
+		 */
+		inline bool is_call_by_id() const { return this->call_by_id_; }
+
 	public:
 		/**
 		 * @function : call a rpc function
@@ -234,7 +252,7 @@ namespace asio2::detail
 					asio::detail::throw_error(asio::error::not_connected);
 
 				header::id_type id = derive.mkid();
-				request<Args...> req(id, std::move(name), std::forward<Args>(args)...);
+				std::string req = this->_make_request(id, name, std::forward<Args>(args)...);
 
 				std::shared_ptr<std::promise<error_code>> promise = std::make_shared<std::promise<error_code>>();
 				std::future<error_code> future = promise->get_future();
@@ -270,11 +288,11 @@ namespace asio2::detail
 				if (!this->wio_.strand().running_in_this_thread())
 				{
 					asio::post(this->wio_.strand(), make_allocator(derive.wallocator(),
-						[this, p = derive.selfptr(), req = std::move(req), cb = std::move(cb)]() mutable
+						[this, p = derive.selfptr(), id, req = std::move(req), cb = std::move(cb)]() mutable
 					{
-						if (derive.send((sr_.reset() << req).str()))
+						if (derive.send(std::move(req)))
 						{
-							this->reqs_.emplace(req.id(), std::move(cb));
+							this->reqs_.emplace(id, std::move(cb));
 						}
 						else
 						{
@@ -427,13 +445,13 @@ namespace asio2::detail
 				if (!derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				request<Args...> req(id, std::move(name), std::forward<Args>(args)...);
+				std::string req = this->_make_request(id, name, std::forward<Args>(args)...);
 
-				auto task = [this, p = derive.selfptr(), req = std::move(req), cb = std::move(cb)]() mutable
+				auto task = [this, p = derive.selfptr(), id, req = std::move(req), cb = std::move(cb)]() mutable
 				{
-					if (derive.send((sr_.reset() << req).str()))
+					if (derive.send(std::move(req)))
 					{
-						this->reqs_.emplace(req.id(), std::move(cb));
+						this->reqs_.emplace(id, std::move(cb));
 					}
 					else
 					{
@@ -469,11 +487,11 @@ namespace asio2::detail
 				if (!derive.is_started())
 					asio::detail::throw_error(asio::error::not_connected);
 
-				request<Args...> req(header::id_type(0), std::move(name), std::forward<Args>(args)...);
+				std::string req = this->_make_request(header::id_type(0), name, std::forward<Args>(args)...);
 
 				auto task = [this, p = derive.selfptr(), req = std::move(req)]() mutable
 				{
-					derive.send((sr_.reset() << req).str());
+					derive.send(std::move(req));
 				};
 
 				asio::post(this->wio_.strand(), make_allocator(derive.wallocator(), std::move(task)));
@@ -487,6 +505,46 @@ namespace asio2::detail
 			set_last_error(ec);
 		}
 
+		/**
+		 * @function : serialize the request in the calling thread, the arguments are written into
+		 * the buffer directly without being copied into a request tuple, so the arguments can be
+		 * views like std::string_view, they only need to be valid until the call function returns.
+		 * the data format is the same as the request<Args...>.
+		 */
+		template<class ...Args>
+		inline std::string _make_request(header::id_type id, const std::string& name, Args&&... args)
+		{
+			// the serializer of the session is used in the io thread only
+			thread_local serializer sr;
+
+			header head(rpc_type_req, id, name);
+			if (this->call_by_id_)
+				head.method(rpc_method_id(name));
+
+			sr.reset();
+			sr << head;
+			((sr << _request_arg(args)), ...);
+
+			return sr.buffer().take();
+		}
+
+		/**
+		 * the raw pointers of the chars are written as the strings, like the request<Args...>
+		 */
+		template<class T>
+		static inline decltype(auto) _request_arg(const T& v)
+		{
+			using ctype = std::remove_cv_t<std::remove_all_extents_t<std::remove_pointer_t<T>>>;
+			if constexpr ((std::is_pointer_v<T> || std::is_array_v<T>) && (
+				std::is_same_v<ctype, std::string::value_type> ||
+				std::is_same_v<ctype, std::wstring::value_type> ||
+				std::is_same_v<ctype, std::u16string::value_type> ||
+				std::is_same_v<ctype, std::u32string::value_type>))
+				return std::basic_string_view<ctype>(v);
+			else
+				return (v);
+		}
+
 	protected:
 		derived_t     & derive;
 
@@ -496,6 +554,8 @@ namespace asio2::detail
 		deserializer  & dr_;
 
 		std::map<header::id_type, std::function<void(error_code, std::string_view)>> reqs_;
+
+		bool            call_by_id_ = false;
 	};
 }
 
@@ -26,6 +26,8 @@
 #include <any>
 #include <future>
 #include <tuple>
+#include <deque>
+#include <vector>
 #include <unordered_map>
 #include <type_traits>
 
@@ -36,6 +38,8 @@
 #include <asio2/base/detail/function_traits.hpp>
 #include <asio2/rpc/detail/serialization.hpp>
 #include <asio2/rpc/detail/protocol.hpp>
+#include <asio2/rpc/detail/rpc_response.hpp>
+#include <asio2/rpc/detail/rpc_exec.hpp>
 
 namespace asio2::detail
 {
@@ -54,8 +58,11 @@ namespace asio2::detail
 	template<typename CallerT>
 	class invoker_t
 	{
+		template <class, bool>  friend class rpc_recv_op;
+
 	public:
 		using self = invoker_t<CallerT>;
+		using function_type = std::function<bool(std::shared_ptr<CallerT>&, CallerT&, header&, serializer&, deserializer&)>;
 
 		/**
 		 * @constructor
@@ -76,14 +83,17 @@ namespace asio2::detail
 		 * @param    : obj - A pointer or reference to a class object, this parameter can be none
 		 * if fun is nonmember function, the obj param must be none, otherwise the obj must be the
 		 * the class object's pointer or refrence.
+		 * The std::string_view parameters point into the received data without copy, they are valid
+		 * only until the function returns.
 		 */
 		template<class F, class ...C>
-		inline self& bind(std::string const& name, F&& fun, C&&... obj)
+		typename std::enable_if_t<!std::is_same_v<std::remove_cv_t<std::remove_reference_t<F>>, rpc_exec_t>, self&>
+			inline bind(std::string const& name, F&& fun, C&&... obj)
 		{
 #if defined(_DEBUG) || defined(DEBUG)
 			{
 				//std::shared_lock<std::shared_mutex> guard(this->mutex_);
-				ASIO2_ASSERT(this->invokers_.find(name) == this->invokers_.end());
+				ASIO2_ASSERT(this->names_.find(name) == this->names_.end());
 			}
 #endif
 			this->_bind(name, std::forward<F>(fun), std::forward<C>(obj)...);
@@ -91,13 +101,39 @@ namespace asio2::detail
 			return (*this);
 		}
 
+		/**
+		 * @function : bind a rpc function with the execution policy
+		 * @param    : exec - where the function is called, see rpc_exec_t
+		 * eg : server.bind("query", asio2::rpc_exec::strand(pool, "db"), &db::query, db);
+		 */
+		template<class F, class ...C>
+		inline self& bind(std::string const& name, rpc_exec_t exec, F&& fun, C&&... obj)
+		{
+			this->bind(name, std::forward<F>(fun), std::forward<C>(obj)...);
+
+			if (!exec.is_io())
+			{
+				function_type& fn = this->invokers_[this->names_[name]];
+				fn = this->_make_exec(std::move(fn), exec);
+			}
+
+			return (*this);
+		}
+
 		/**
 		 * @function : unbind a rpc function
 		 */
 		inline self& unbind(std::string const& name)
 		{
 			//std::unique_lock<std::shared_mutex> guard(this->mutex_);
-			this->invokers_.erase(name);
+			auto iter = this->names_.find(name);
+			if (iter == this->names_.end())
+				return (*this);
+
+			// the slot is kept, so the indexes of the other functions are unchanged
+			this->invokers_[iter->second] = nullptr;
+			this->names_.erase(iter);
+			this->_rebuild_methods();
 
 			return (*this);
 		}
@@ -105,13 +141,32 @@ namespace asio2::detail
 		/**
 		 * @function : find binded rpc function by name
 		 */
-		inline std::function<void(std::shared_ptr<CallerT>&, serializer&, deserializer&)>* find(std::string const& name)
+		inline function_type* find(std::string const& name)
 		{
 			//std::shared_lock<std::shared_mutex> guard(this->mutex_);
-			auto iter = this->invokers_.find(name);
-			if (iter == this->invokers_.end())
+			auto iter = this->names_.find(name);
+			if (iter == this->names_.end())
 				return nullptr;
-			return (&(iter->second));
+			return (&(this->invokers_[iter->second]));
+		}
+
+		/**
+		 * @function : find binded rpc function by the method id of the name
+		 */
+		inline function_type* find(std::uint32_t method)
+		{
+			std::size_t mask = this->methods_.size() - 1;
+			for (std::size_t i = _hash(method) & mask; this->methods_[i].index; i = (i + 1) & mask)
+			{
+				if (this->methods_[i].method == method)
+				{
+					if (this->methods_[i].index == ambiguous)
+						return nullptr;
+					function_type & fn = this->invokers_[this->methods_[i].index - 1];
+					return (fn ? &fn : nullptr);
+				}
+			}
+			return nullptr;
 		}
 
 	protected:
@@ -124,45 +179,192 @@ namespace asio2::detail
 		inline void _bind(std::string const& name, F f)
 		{
 			//std::unique_lock<std::shared_mutex> guard(this->mutex_);
-			this->invokers_[name] = std::bind(&self::template _proxy<F>, this, std::move(f),
-				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+			this->_emplace(name, std::bind(&self::template _proxy<F>, this, std::move(f),
+				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4,
+				std::placeholders::_5));
 		}
 
 		template<class F, class C>
 		inline void _bind(std::string const& name, F f, C& c)
 		{
 			//std::unique_lock<std::shared_mutex> guard(this->mutex_);
-			this->invokers_[name] = std::bind(&self::template _proxy<F, C>, this, std::move(f), &c,
-				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+			this->_emplace(name, std::bind(&self::template _proxy<F, C>, this, std::move(f), &c,
+				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4,
+				std::placeholders::_5));
 		}
 
 		template<class F, class C>
 		inline void _bind(std::string const& name, F f, C* c)
 		{
 			//std::unique_lock<std::shared_mutex> guard(this->mutex_);
-			this->invokers_[name] = std::bind(&self::template _proxy<F, C>, this, std::move(f), c,
-				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+			this->_emplace(name, std::bind(&self::template _proxy<F, C>, this, std::move(f), c,
+				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4,
+				std::placeholders::_5));
+		}
+
+		/**
+		 * @function : wrap the function, the request is copied and the function is called by the policy
+		 */
+		inline function_type _make_exec(function_type&& fn, rpc_exec_t& exec)
+		{
+			std::function<void(std::function<void()>)> post;
+
+			if (exec.strand_.empty())
+			{
+				post = [pool = exec.pool_](std::function<void()> task)
+				{
+					pool->post(std::move(task));
+				};
+			}
+			else
+			{
+				std::shared_ptr<rpc_strand_t>& strand = this->strands_[exec.strand_];
+				if (!strand)
+					strand = std::make_shared<rpc_strand_t>(*exec.pool_);
+
+				// the strand is run by the pool which it's created with
+				ASIO2_ASSERT(&(strand->pool()) == exec.pool_);
+
+				post = [strand](std::function<void()> task)
+				{
+					strand->post(std::move(task));
+				};
+			}
+
+			return [fp = std::make_shared<function_type>(std::move(fn)), post = std::move(post)]
+			(std::shared_ptr<CallerT>& caller, CallerT& self, header&, serializer&, deserializer& dr) -> bool
+			{
+				// the recv buffer is reused by the next request, so the whole request is copied
+				post([fp, caller, p = &self, req = std::string(dr.buffer().str())]() mutable
+				{
+					thread_local serializer sr;
+					thread_local deserializer dr;
+
+					header head;
+
+					try
+					{
+						dr.reset(req);
+						dr >> head;
+					}
+					catch (cereal::exception&) { return; }
+
+					head.as_response();
+					sr.reset();
+					sr << head;
+
+					if (invoker_t::_execute(*fp, caller, *p, head, sr, dr) && head.id() != header::id_type(0))
+					{
+						p->send(std::string(sr.str()));
+					}
+				});
+
+				return false;
+			};
+		}
+
+		/**
+		 * @function : call the function, the result or the error is written into the serializer
+		 * @return   : false if the function is deferred, the result isn't in the serializer
+		 */
+		static inline bool _execute(function_type& fn, std::shared_ptr<CallerT>& caller, CallerT& self,
+			header& head, serializer& sr, deserializer& dr)
+		{
+			try
+			{
+				if (!fn(caller, self, head, sr, dr))
+					return false;
+
+				// The number of parameters passed in when calling rpc function exceeds 
+				// the number of parameters of local function
+				if (dr.buffer().in_avail() != 0 && head.id() != header::id_type(0))
+				{
+					sr.reset();
+					sr << head;
+					asio::detail::throw_error(asio::error::invalid_argument);
+				}
+			}
+			catch (cereal::exception&) { sr << error_code{ asio::error::no_data }; }
+			catch (system_error& e) { sr << e.code(); }
+			catch (std::exception&) { sr << error_code{ asio::error::eof }; }
+
+			return true;
+		}
+
+		inline void _emplace(std::string const& name, function_type&& fn)
+		{
+			auto iter = this->names_.find(name);
+			if (iter != this->names_.end())
+			{
+				this->invokers_[iter->second] = std::move(fn);
+				return;
+			}
+
+			this->names_.emplace(name, static_cast<std::uint32_t>(this->invokers_.size()));
+			this->invokers_.emplace_back(std::move(fn));
+			this->_rebuild_methods();
+		}
+
+		static inline std::size_t _hash(std::uint32_t method)
+		{
+			return static_cast<std::size_t>((std::uint64_t(method) * std::uint64_t(0x9E3779B97F4A7C15)) >> 32);
+		}
+
+		/**
+		 * the method table is an open addressing hash table with linear probing, it's rebuilt when
+		 * a function is bound or unbound, the load factor is not greater than 1/2.
+		 */
+		inline void _rebuild_methods()
+		{
+			std::size_t capacity = 16;
+			while (capacity < this->names_.size() * 2)
+				capacity *= 2;
+
+			this->methods_.assign(capacity, method_slot{});
+
+			std::size_t mask = capacity - 1;
+			for (auto & [name, index] : this->names_)
+			{
+				std::uint32_t method = rpc_method_id(name);
+				std::size_t i = _hash(method) & mask;
+				for (; this->methods_[i].index; i = (i + 1) & mask)
+				{
+					if (this->methods_[i].method == method)
+						break;
+				}
+
+				if (this->methods_[i].index)
+				{
+					// the method ids of two names are equal, the functions must be called by name
+					ASIO2_ASSERT(false);
+					this->methods_[i].index = ambiguous;
+					continue;
+				}
+
+				this->methods_[i].method = method;
+				this->methods_[i].index  = index + 1;
+			}
 		}
 
 		template<class F>
-		inline void _proxy(F f, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
+		inline bool _proxy(F f, std::shared_ptr<CallerT>& caller, CallerT& self, header& head, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 
-			_argc_proxy<fun_traits_type::argc>(f, caller, sr, dr);
+			return _argc_proxy<fun_traits_type::argc>(f, caller, self, head, sr, dr);
 		}
 
 		template<class F, class C>
-		inline void _proxy(F f, C* c, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
+		inline bool _proxy(F f, C* c, std::shared_ptr<CallerT>& caller, CallerT& self, header& head, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 
-			_argc_proxy<fun_traits_type::argc>(f, c, caller, sr, dr);
+			return _argc_proxy<fun_traits_type::argc>(f, c, caller, self, head, sr, dr);
 		}
 
 		template<std::size_t Argc, class F>
-		typename std::enable_if_t<Argc == 0>
-			inline _argc_proxy(const F& f, std::shared_ptr<CallerT>&, serializer& sr, deserializer& dr)
+		typename std::enable_if_t<Argc == 0, bool>
+			inline _argc_proxy(const F& f, std::shared_ptr<CallerT>&, CallerT&, header&, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 			using fun_args_tuple = typename fun_traits_type::pod_tuple_type;
@@ -171,11 +373,12 @@ namespace asio2::detail
 			fun_args_tuple tp;
 			dr >> tp;
 			_invoke<fun_ret_type>(f, sr, dr, tp);
+			return true;
 		}
 
 		template<std::size_t Argc, class F, class C>
-		typename std::enable_if_t<Argc == 0>
-			inline _argc_proxy(const F& f, C* c, std::shared_ptr<CallerT>&, serializer& sr, deserializer& dr)
+		typename std::enable_if_t<Argc == 0, bool>
+			inline _argc_proxy(const F& f, C* c, std::shared_ptr<CallerT>&, CallerT&, header&, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 			using fun_args_tuple = typename fun_traits_type::pod_tuple_type;
@@ -184,11 +387,15 @@ namespace asio2::detail
 			fun_args_tuple tp;
 			dr >> tp;
 			_invoke<fun_ret_type>(f, c, sr, dr, tp);
+			return true;
 		}
 
+		/**
+		 * @return : false if the function is deferred, the response is sent when the token is completed
+		 */
 		template<std::size_t Argc, class F>
-		typename std::enable_if_t<Argc != 0>
-			inline _argc_proxy(const F& f, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
+		typename std::enable_if_t<Argc != 0, bool>
+			inline _argc_proxy(const F& f, std::shared_ptr<CallerT>& caller, CallerT& self, header& head, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 			using fun_args_tuple = typename fun_traits_type::pod_tuple_type;
@@ -196,22 +403,44 @@ namespace asio2::detail
 			using arg0_type = typename std::remove_cv_t<std::remove_reference_t<typename fun_traits_type::template args<0>::type>>;
 
 			if constexpr (std::is_same_v<std::shared_ptr<CallerT>, arg0_type>)
+			{
+				if constexpr (_is_deferred<fun_traits_type, 1>())
+				{
+					using rep_type = std::tuple_element_t<1, fun_args_tuple>;
+					auto tp = _tail_args_tuple<2>((fun_args_tuple*)0);
+					dr >> tp;
+					rep_type rep = _make_response<rep_type>(caller, self, head, dr);
+					_invoke_deferred(rep, f, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&, rep_type&>(caller, rep), tp));
+					return false;
+				}
+				else
+				{
+					auto tp = _body_args_tuple((fun_args_tuple*)0);
+					dr >> tp;
+					_invoke<fun_ret_type>(f, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
+					return true;
+				}
+			}
+			else if constexpr (_is_deferred<fun_traits_type, 0>())
 			{
 				auto tp = _body_args_tuple((fun_args_tuple*)0);
 				dr >> tp;
-				_invoke<fun_ret_type>(f, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
+				arg0_type rep = _make_response<arg0_type>(caller, self, head, dr);
+				_invoke_deferred(rep, f, std::tuple_cat(std::tuple<arg0_type&>(rep), tp));
+				return false;
 			}
 			else
 			{
 				fun_args_tuple tp;
 				dr >> tp;
 				_invoke<fun_ret_type>(f, sr, dr, tp);
+				return true;
 			}
 		}
 
 		template<std::size_t Argc, class F, class C>
-		typename std::enable_if_t<Argc != 0>
-			inline _argc_proxy(const F& f, C* c, std::shared_ptr<CallerT>& caller, serializer& sr, deserializer& dr)
+		typename std::enable_if_t<Argc != 0, bool>
+			inline _argc_proxy(const F& f, C* c, std::shared_ptr<CallerT>& caller, CallerT& self, header& head, serializer& sr, deserializer& dr)
 		{
 			using fun_traits_type = function_traits<F>;
 			using fun_args_tuple = typename fun_traits_type::pod_tuple_type;
@@ -219,29 +448,142 @@ namespace asio2::detail
 			using arg0_type = typename std::remove_cv_t<std::remove_reference_t<typename fun_traits_type::template args<0>::type>>;
 
 			if constexpr (std::is_same_v<std::shared_ptr<CallerT>, arg0_type>)
+			{
+				if constexpr (_is_deferred<fun_traits_type, 1>())
+				{
+					using rep_type = std::tuple_element_t<1, fun_args_tuple>;
+					auto tp = _tail_args_tuple<2>((fun_args_tuple*)0);
+					dr >> tp;
+					rep_type rep = _make_response<rep_type>(caller, self, head, dr);
+					_invoke_deferred(rep, f, c, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&, rep_type&>(caller, rep), tp));
+					return false;
+				}
+				else
+				{
+					auto tp = _body_args_tuple((fun_args_tuple*)0);
+					dr >> tp;
+					_invoke<fun_ret_type>(f, c, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
+					return true;
+				}
+			}
+			else if constexpr (_is_deferred<fun_traits_type, 0>())
 			{
 				auto tp = _body_args_tuple((fun_args_tuple*)0);
 				dr >> tp;
-				_invoke<fun_ret_type>(f, c, sr, dr, std::tuple_cat(std::tuple<std::shared_ptr<CallerT>&>(caller), tp));
+				arg0_type rep = _make_response<arg0_type>(caller, self, head, dr);
+				_invoke_deferred(rep, f, c, std::tuple_cat(std::tuple<arg0_type&>(rep), tp));
+				return false;
 			}
 			else
 			{
 				fun_args_tuple tp;
 				dr >> tp;
 				_invoke<fun_ret_type>(f, c, sr, dr, tp);
+				return true;
+			}
+		}
+
+		/**
+		 * @function : check whether the I-th parameter of the function is the response token
+		 */
+		template<class FunTraits, std::size_t I>
+		static constexpr bool _is_deferred()
+		{
+			if constexpr (I < FunTraits::argc)
+			{
+				if constexpr (is_rpc_response_v<typename FunTraits::template args<I>::type>)
+				{
+					static_assert(std::is_void_v<typename FunTraits::return_type>,
+						"the function which has the response token must return void");
+					static_assert(!_has_string_view((typename FunTraits::pod_tuple_type*)0),
+						"the deferred function can't have a string_view parameter, it points into the recv "
+						"buffer which is invalid after the function returns, use std::string instead");
+					return true;
+				}
+				else
+					return false;
 			}
+			else
+				return false;
+		}
+
+		template<typename... Args>
+		static constexpr bool _has_string_view(std::tuple<Args...>*)
+		{
+			return (false || ... || is_string_view_v<Args>);
+		}
+
+		template<class Response>
+		inline Response _make_response(std::shared_ptr<CallerT>& caller, CallerT& self, header& head, deserializer& dr)
+		{
+			// The number of parameters passed in when calling rpc function exceeds
+			// the number of parameters of local function
+			if (dr.buffer().in_avail() != 0 && head.id() != header::id_type(0))
+				asio::detail::throw_error(asio::error::invalid_argument);
+
+			Response rep;
+			rep.state_ = std::make_shared<typename Response::state>();
+			rep.state_->head = head;
+			// the token holds the caller, so the caller is valid until the token is destroyed
+			rep.state_->sender = [keeper = caller, p = &self](std::string&& s)
+			{
+				ignore::unused(keeper);
+				return p->send(std::move(s));
+			};
+			return rep;
 		}
 
 		template<typename... Args>
 		inline decltype(auto) _body_args_tuple(std::tuple<Args...>* tp)
 		{
-			return (_body_args_tuple_impl(std::make_index_sequence<sizeof...(Args) - 1>{}, tp));
+			return (_tail_args_tuple<1>(tp));
 		}
 
-		template<std::size_t... I, typename... Args>
-		inline decltype(auto) _body_args_tuple_impl(const std::index_sequence<I...>&, std::tuple<Args...>*)
+		/**
+		 * @function : get the tuple of the parameters except the first N parameters
+		 */
+		template<std::size_t N, typename... Args>
+		inline decltype(auto) _tail_args_tuple(std::tuple<Args...>* tp)
+		{
+			return (_tail_args_tuple_impl<N>(std::make_index_sequence<sizeof...(Args) - N>{}, tp));
+		}
+
+		template<std::size_t N, std::size_t... I, typename... Args>
+		inline decltype(auto) _tail_args_tuple_impl(const std::index_sequence<I...>&, std::tuple<Args...>*)
+		{
+			return (std::tuple<typename std::tuple_element<I + N, std::tuple<Args...>>::type...>{});
+		}
+
+		/**
+		 * if the function throws, the error is sent by the invoker, so the token is discarded,
+		 * otherwise the destroyed token sends the operation_aborted too.
+		 */
+		template<typename Response, typename F, typename... Args>
+		inline void _invoke_deferred(Response& rep, const F& f, const std::tuple<Args...>& tp)
 		{
-			return (std::tuple<typename std::tuple_element<I + 1, std::tuple<Args...>>::type...>{});
+			try
+			{
+				_invoke_impl<void>(f, std::make_index_sequence<sizeof...(Args)>{}, tp);
+			}
+			catch (...)
+			{
+				rep._discard();
+				throw;
+			}
+		}
+
+		template<typename Response, typename F, typename C, typename... Args>
+		inline void _invoke_deferred(Response& rep, const F& f, C* c, const std::tuple<Args...>& tp)
+		{
+			try
+			{
+				_invoke_impl<void>(f, c, std::make_index_sequence<sizeof...(Args)>{}, tp);
+			}
+			catch (...)
+			{
+				rep._discard();
+				throw;
+			}
 		}
 
 		template<typename R, typename F, typename... Args>
@@ -307,9 +649,28 @@ namespace asio2::detail
 		}
 
 	protected:
+		static constexpr std::uint32_t ambiguous = std::uint32_t(-1);
+
+		struct method_slot
+		{
+			std::uint32_t method = 0;
+			/// the index of the function plus 1, 0 means the slot is empty
+			std::uint32_t index  = 0;
+		};
+
 		//std::shared_mutex                           mutex_;
 
-		std::unordered_map<std::string, std::function<void(std::shared_ptr<CallerT>&, serializer&, deserializer&)>> invokers_;
+		/// the functions, the deque keeps the function valid when other functions are bound
+		std::deque<function_type>                         invokers_;
+
+		/// the function name to the index of the function
+		std::unordered_map<std::string, std::uint32_t>    names_;
+
+		/// the method id to the index of the function
+		std::vector<method_slot>                          methods_ = std::vector<method_slot>(16);
+
+		/// the named strands of the functions
+		std::unordered_map<std::string, std::shared_ptr<rpc_strand_t>> strands_;
 	};
 }
 
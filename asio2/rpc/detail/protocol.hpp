@@ -15,6 +15,7 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -26,13 +27,35 @@ namespace asio2::detail
 	 * request  : message type + request id + function name + parameters value...
 	 * response : message type + request id + function name + error code + result value
 	 *
-	 * message type : q - request, p - response
+	 * request  : message type + request id + method id + parameters value...
+	 * response : message type + request id + error code + result value
+	 *
+	 * message type : q - request, p - response, Q - request by method id, P - response of Q
+	 *
+	 * the method id is the 32 bits fnv-1a hash of the function name, so the name needn't to be
+	 * sent and be looked up by string on every call.
 	 *
 	 * if result type is void, then result type will wrapped to std::int8_t
 	 */
 
-	static constexpr char rpc_type_req = 'q';
-	static constexpr char rpc_type_rep = 'p';
+	static constexpr char rpc_type_req    = 'q';
+	static constexpr char rpc_type_rep    = 'p';
+	static constexpr char rpc_type_req_id = 'Q';
+	static constexpr char rpc_type_rep_id = 'P';
+
+	/**
+	 * @function : get the method id of the rpc function name, it can be evaluated at compile time.
+	 */
+	constexpr std::uint32_t rpc_method_id(std::string_view name)
+	{
+		std::uint32_t h = 2166136261u;
+		for (char c : name)
+		{
+			h ^= static_cast<std::uint8_t>(c);
+			h *= 16777619u;
+		}
+		return h;
+	}
 
 	class header
 	{
@@ -44,13 +67,14 @@ namespace asio2::detail
 			: type_(type), id_(id), name_(name) {}
 		~header() = default;
 
-		header(const header& r) : type_(r.type_), id_(r.id_), name_(r.name_) {}
-		header(header&& r) : type_(r.type_), id_(r.id_), name_(std::move(r.name_)) {}
+		header(const header& r) : type_(r.type_), id_(r.id_), method_(r.method_), name_(r.name_) {}
+		header(header&& r) : type_(r.type_), id_(r.id_), method_(r.method_), name_(std::move(r.name_)) {}
 
 		inline header& operator=(const header& r)
 		{
 			type_ = r.type_;
 			id_ = r.id_;
+			method_ = r.method_;
 			name_ = r.name_;
 			return (*this);
 		}
@@ -58,6 +82,7 @@ namespace asio2::detail
 		{
 			type_ = r.type_;
 			id_ = r.id_;
+			method_ = r.method_;
 			name_ = std::move(r.name_);
 			return (*this);
 		}
@@ -65,23 +90,50 @@ namespace asio2::detail
 		template <class Archive>
 		inline void serialize(Archive & ar)
 		{
-			ar(type_, id_, name_);
+			ar(type_, id_);
+
+			if /**/ (type_ == rpc_type_req || type_ == rpc_type_rep)
+				ar(name_);
+			else if (type_ == rpc_type_req_id)
+				ar(method_);
 		}
 
-		inline const char         type() const { return this->type_; }
-		inline const id_type      id()   const { return this->id_;   }
-		inline const std::string& name() const { return this->name_; }
+		inline const char         type()   const { return this->type_;   }
+		inline const id_type      id()     const { return this->id_;     }
+		inline std::uint32_t      method() const { return this->method_; }
+		inline const std::string& name()   const { return this->name_;   }
 
-		inline bool is_request()  { return this->type_ == rpc_type_req; }
-		inline bool is_response() { return this->type_ == rpc_type_rep; }
+		inline bool is_request()  { return this->type_ == rpc_type_req || this->type_ == rpc_type_req_id; }
+		inline bool is_response() { return this->type_ == rpc_type_rep || this->type_ == rpc_type_rep_id; }
+		inline bool is_by_id()    { return this->type_ == rpc_type_req_id || this->type_ == rpc_type_rep_id; }
 
 		inline header& type(char type            ) { this->type_ = type; return (*this); }
 		inline header& id  (id_type id           ) { this->id_   = id  ; return (*this); }
 		inline header& name(std::string_view name) { this->name_ = name; return (*this); }
 
+		/**
+		 * @function : send the request by the method id instead of the function name
+		 */
+		inline header& method(std::uint32_t method)
+		{
+			this->type_ = rpc_type_req_id;
+			this->method_ = method;
+			return (*this);
+		}
+
+		/**
+		 * @function : make the header of the response of this request
+		 */
+		inline header& as_response()
+		{
+			this->type_ = (this->type_ == rpc_type_req_id ? rpc_type_rep_id : rpc_type_rep);
+			return (*this);
+		}
+
 	protected:
 		char           type_;
 		id_type        id_ = 0;
+		std::uint32_t  method_ = 0;
 		std::string    name_;
 	};
 
@@ -0,0 +1,150 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_RPC_EXEC_HPP__
+#define __ASIO2_RPC_EXEC_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <functional>
+
+#include <asio2/util/thread_pool.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * The execution policy of a rpc function :
+	 * io     - the function is called in the io thread which received the request, it's the default
+	 * pool   - the function is called in a thread of the thread pool, for the cpu heavy functions
+	 * strand - the functions which have the same strand name are called one by one in the thread
+	 *          pool, for the functions which share a state
+	 * The result is always sent by the session or the client which received the request.
+	 * The tasks in the thread pool refer to the server or the client, so they must be destroyed in
+	 * this order : stop the server or the client, then destroy the thread pool, which waits for the
+	 * tasks, and destroy the server or the client at last.
+	 * eg : server.bind("hash", asio2::rpc_exec::pool(pool), hash);
+	 */
+	class rpc_exec_t
+	{
+		template<typename> friend class invoker_t;
+
+	public:
+		rpc_exec_t() = default;
+
+		static inline rpc_exec_t io()
+		{
+			return rpc_exec_t{};
+		}
+
+		static inline rpc_exec_t pool(thread_pool& pool)
+		{
+			rpc_exec_t exec;
+			exec.pool_ = &pool;
+			return exec;
+		}
+
+		static inline rpc_exec_t strand(thread_pool& pool, std::string name)
+		{
+			rpc_exec_t exec;
+			exec.pool_ = &pool;
+			exec.strand_ = std::move(name);
+			return exec;
+		}
+
+		/**
+		 * @function : check whether the function is called in the io thread
+		 */
+		inline bool is_io() const { return (this->pool_ == nullptr); }
+
+	protected:
+		thread_pool * pool_ = nullptr;
+
+		/// the name of the strand, empty means not in a strand
+		std::string   strand_;
+	};
+
+	/**
+	 * The tasks which are posted into the strand are run one by one in the thread pool.
+	 */
+	class rpc_strand_t : public std::enable_shared_from_this<rpc_strand_t>
+	{
+	public:
+		explicit rpc_strand_t(thread_pool& pool) : pool_(pool) {}
+
+		inline void post(std::function<void()> task)
+		{
+			{
+				std::unique_lock<std::mutex> lock(this->mtx_);
+				this->tasks_.emplace(std::move(task));
+				if (this->running_)
+					return;
+				this->running_ = true;
+			}
+
+			try
+			{
+				this->pool_.post([this_ptr = this->shared_from_this()]() { this_ptr->_run(); });
+			}
+			catch (std::exception&)
+			{
+				std::unique_lock<std::mutex> lock(this->mtx_);
+				this->tasks_ = {};
+				this->running_ = false;
+				throw;
+			}
+		}
+
+		inline thread_pool& pool() { return this->pool_; }
+
+	protected:
+		inline void _run()
+		{
+			for (;;)
+			{
+				std::function<void()> task;
+
+				{
+					std::unique_lock<std::mutex> lock(this->mtx_);
+					if (this->tasks_.empty())
+					{
+						this->running_ = false;
+						return;
+					}
+					task = std::move(this->tasks_.front());
+					this->tasks_.pop();
+				}
+
+				task();
+			}
+		}
+
+	protected:
+		thread_pool                       & pool_;
+
+		std::mutex                          mtx_;
+		std::queue<std::function<void()>>   tasks_;
+
+		/// whether a thread of the pool is running the tasks
+		bool                                running_ = false;
+	};
+}
+
+namespace asio2
+{
+	using rpc_exec = detail::rpc_exec_t;
+}
+
+#endif // !__ASIO2_RPC_EXEC_HPP__
@@ -31,7 +31,9 @@
 
 #include <cereal/cereal.hpp>
 
-#include <sstream>
+#include <cstring>
+#include <string>
+#include <string_view>
 #include <limits>
 
 namespace cereal
@@ -56,11 +58,86 @@ namespace cereal
       for( std::size_t i = 0, end = DataSize / 2; i < end; ++i )
         std::swap( data[i], data[DataSize - i - 1] );
     }
+
+    //! The contiguous output buffer, the output archive appends the data to it directly
+    /*! The buffer isn't released by clear, so the buffer can be reused without allocation
+        @ingroup Internal */
+    class ostrbuf
+    {
+      public:
+        using string_type = std::string;
+        using size_type = typename string_type::size_type;
+
+        inline const string_type & str() const
+        { return str_; }
+
+        inline void clear()
+        { str_.clear(); }
+
+        //! Moves the data out, the buffer is empty after it
+        inline string_type take()
+        {
+          string_type s;
+          s.swap( str_ );
+          return s;
+        }
+
+        inline void write( const void * data, std::size_t size )
+        { str_.append( reinterpret_cast<const char*>( data ), size ); }
+
+        //! Appends size bytes to the buffer and returns the pointer to them
+        inline char * grow( std::size_t size )
+        {
+          size_type n = str_.size();
+          str_.resize( n + size );
+          return str_.data() + n;
+        }
+
+      protected:
+        string_type str_;
+    };
+
+    //! The contiguous input buffer, the input archive reads the data from it directly
+    /*! The buffer doesn't own the data
+        @ingroup Internal */
+    class istrbuf
+    {
+      public:
+        inline void setbuf( std::string_view s )
+        {
+          begin_ = s.data();
+          ptr_   = begin_;
+          end_   = begin_ + s.size();
+        }
+
+        //! Gets the size of the data which isn't read yet
+        inline std::streamsize in_avail() const
+        { return static_cast<std::streamsize>( end_ - ptr_ ); }
+
+        //! Gets the whole buffer, include the data which is read already
+        inline std::string_view str() const
+        { return std::string_view( begin_, static_cast<std::size_t>( end_ - begin_ ) ); }
+
+        //! Consumes size bytes and returns the pointer to them, or nullptr if there is not enough data
+        inline const char * read( std::size_t size )
+        {
+          if( size > static_cast<std::size_t>( end_ - ptr_ ) )
+            return nullptr;
+          const char * p = ptr_;
+          ptr_ += size;
+          return p;
+        }
+
+      protected:
+        const char * begin_ = nullptr;
+        const char * ptr_   = nullptr;
+        const char * end_   = nullptr;
+    };
   } // end namespace rpc_portable_binary_detail
 
   // ######################################################################
   //! An output archive designed to save data in a compact binary representation portable over different architectures
-  /*! This archive outputs data to a stream in an extremely compact binary
+  /*! This archive outputs data to a contiguous buffer in an extremely compact binary
       representation with as little extra metadata as possible.
 
       This archive will record the endianness of the data as well as the desired in/out endianness
@@ -114,13 +191,13 @@ namespace cereal
           Endianness itsOutputEndianness;
       };
 
-      //! Construct, outputting to the provided stream
-      /*! @param stream The stream to output to. Should be opened with std::ios::binary flag.
+      //! Construct, outputting to the provided buffer
+      /*! @param buffer The buffer to output to, there is no stream between the archive and the buffer.
           @param options The PortableBinary specific options to use.  See the Options struct
                          for the values of default parameters */
-      RPCPortableBinaryOutputArchive(std::ostream & stream, Options const & options = Options::Default()) :
+      RPCPortableBinaryOutputArchive(rpc_portable_binary_detail::ostrbuf & buffer, Options const & options = Options::Default()) :
         OutputArchive<RPCPortableBinaryOutputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream),
+        itsBuffer(buffer),
         itsConvertEndianness( rpc_portable_binary_detail::is_little_endian() ^ options.is_little_endian() )
       {
 		options_.itsOutputEndianness = options.itsOutputEndianness;
@@ -134,34 +211,37 @@ namespace cereal
 		return (*this);
       }
 
-      //! Writes size bytes of data to the output stream
+      //! Writes size bytes of data to the output buffer
       template <std::streamsize DataSize> inline
       void saveBinary( const void * data, std::streamsize size )
       {
-        std::streamsize writtenSize = 0;
-
-        if( itsConvertEndianness )
+        // the bytes needn't be swapped, the data is copied at once
+        if constexpr( DataSize == 1 )
+          itsBuffer.write( data, static_cast<std::size_t>( size ) );
+        else
         {
-          for( std::streamsize i = 0; i < size; i += DataSize )
-            for( std::streamsize j = 0; j < DataSize; ++j )
-              writtenSize += itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ) + DataSize - j - 1 + i, 1 );
+          if( itsConvertEndianness )
+          {
+            const char * src = reinterpret_cast<const char*>( data );
+            char * dst = itsBuffer.grow( static_cast<std::size_t>( size ) );
+            for( std::streamsize i = 0; i < size; i += DataSize )
+              for( std::streamsize j = 0; j < DataSize; ++j )
+                dst[i + j] = src[i + DataSize - j - 1];
+          }
+          else
+            itsBuffer.write( data, static_cast<std::size_t>( size ) );
         }
-        else
-          writtenSize = itsStream.rdbuf()->sputn( reinterpret_cast<const char*>( data ), size );
-
-        if(writtenSize != size)
-          throw Exception("Failed to write " + std::to_string(size) + " bytes to output stream! Wrote " + std::to_string(writtenSize));
       }
 
     private:
-      std::ostream & itsStream;
+      rpc_portable_binary_detail::ostrbuf & itsBuffer;
       const uint8_t itsConvertEndianness; //!< If set to true, we will need to swap bytes upon saving
 	  Options options_;
   };
 
   // ######################################################################
   //! An input archive designed to load data saved using RPCPortableBinaryOutputArchive
-  /*! This archive outputs data to a stream in an extremely compact binary
+  /*! This archive loads data from a contiguous buffer in an extremely compact binary
       representation with as little extra metadata as possible.
 
       This archive will load the endianness of the serialized data and
@@ -223,13 +303,13 @@ namespace cereal
           Endianness itsInputEndianness;
       };
 
-      //! Construct, loading from the provided stream
-      /*! @param stream The stream to read from. Should be opened with std::ios::binary flag.
+      //! Construct, loading from the provided buffer
+      /*! @param buffer The buffer to read from, there is no stream between the archive and the buffer.
           @param options The PortableBinary specific options to use.  See the Options struct
                          for the values of default parameters */
-      RPCPortableBinaryInputArchive(std::istream & stream, Options const & options = Options::Default()) :
+      RPCPortableBinaryInputArchive(rpc_portable_binary_detail::istrbuf & buffer, Options const & options = Options::Default()) :
         InputArchive<RPCPortableBinaryInputArchive, AllowEmptyClassElision>(this),
-        itsStream(stream),
+        itsBuffer(buffer),
         itsConvertEndianness( false )
       {
 		options_.itsInputEndianness = options.itsInputEndianness;
@@ -245,7 +325,7 @@ namespace cereal
 		return (*this);
       }
 
-      //! Reads size bytes of data from the input stream
+      //! Reads size bytes of data from the input buffer
       /*! @param data The data to save
           @param size The number of bytes in the data
           @tparam DataSize T The size of the actual type of the data elements being loaded */
@@ -253,22 +333,28 @@ namespace cereal
       void loadBinary( void * const data, std::streamsize size )
       {
         // load data
-        auto const readSize = itsStream.rdbuf()->sgetn( reinterpret_cast<char*>( data ), size );
+        const char * src = itsBuffer.read( static_cast<std::size_t>( size ) );
+
+        if( !src )
+          throw Exception("Failed to read " + std::to_string(size) + " bytes from input buffer! Available " + std::to_string(itsBuffer.in_avail()));
 
-        if(readSize != size)
-          throw Exception("Failed to read " + std::to_string(size) + " bytes from input stream! Read " + std::to_string(readSize));
+        if( size != 0 )
+          std::memcpy( data, src, static_cast<std::size_t>( size ) );
 
         // flip bits if needed
-        if( itsConvertEndianness )
+        if constexpr( DataSize != 1 )
         {
-          std::uint8_t * ptr = reinterpret_cast<std::uint8_t*>( data );
-          for( std::streamsize i = 0; i < size; i += DataSize )
-            rpc_portable_binary_detail::swap_bytes<DataSize>( ptr + i );
+          if( itsConvertEndianness )
+          {
+            std::uint8_t * ptr = reinterpret_cast<std::uint8_t*>( data );
+            for( std::streamsize i = 0; i < size; i += DataSize )
+              rpc_portable_binary_detail::swap_bytes<DataSize>( ptr + i );
+          }
         }
       }
 
     private:
-      std::istream & itsStream;
+      rpc_portable_binary_detail::istrbuf & itsBuffer;
       uint8_t itsConvertEndianness; //!< If set to true, we will need to swap bytes upon loading
 	  Options options_;
   };
@@ -0,0 +1,185 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_RPC_RESPONSE_HPP__
+#define __ASIO2_RPC_RESPONSE_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#include <asio2/rpc/detail/serialization.hpp>
+#include <asio2/rpc/detail/protocol.hpp>
+
+namespace asio2::detail
+{
+	template<typename> class invoker_t;
+
+	/**
+	 * The response token of the deferred rpc function, the function which has a rpc_response<T>
+	 * parameter returns without the result, and the result is sent to the caller when the token
+	 * is completed later, the token can be copied and be completed in any thread, only the first
+	 * completion is sent. If the last copy of the token is destroyed without being completed, the
+	 * operation_aborted error is sent to the caller.
+	 * eg : server.bind("query", [](asio2::rpc_response<int> rep, int key) { ... rep.set_value(v); });
+	 * the token may be the second parameter if the first parameter is the session shared_ptr.
+	 */
+	template<class T>
+	class rpc_response_t
+	{
+		template<typename> friend class invoker_t;
+
+	public:
+		using value_type = T;
+
+		rpc_response_t() = default;
+		~rpc_response_t() = default;
+
+		rpc_response_t(const rpc_response_t&) = default;
+		rpc_response_t(rpc_response_t&&) = default;
+		rpc_response_t& operator=(const rpc_response_t&) = default;
+		rpc_response_t& operator=(rpc_response_t&&) = default;
+
+		/**
+		 * @function : send the result to the caller
+		 * @return   : false if the token is completed already or the result can't be sent
+		 */
+		template<class V = T>
+		inline typename std::enable_if_t<!std::is_void_v<V>, bool> set_value(V value)
+		{
+			return this->_complete(error_code{}, [&value](serializer& sr) { sr << value; });
+		}
+
+		/**
+		 * @function : tell the caller that the function is completed, just used for void result
+		 */
+		template<class V = T>
+		inline typename std::enable_if_t<std::is_void_v<V>, bool> set_value()
+		{
+			return this->_complete(error_code{}, [](serializer&) {});
+		}
+
+		/**
+		 * @function : send the error to the caller
+		 */
+		inline bool set_error(const error_code& ec)
+		{
+			return this->_complete(ec, [](serializer&) {});
+		}
+
+		/**
+		 * @function : check whether the token is not completed yet
+		 */
+		inline bool pending() const
+		{
+			return (this->state_ && !this->state_->done.load(std::memory_order_acquire));
+		}
+
+	protected:
+		struct state
+		{
+			~state()
+			{
+				// the last copy of the token is destroyed without being completed
+				if (!this->done.exchange(true, std::memory_order_acq_rel) && this->sender)
+				{
+					try
+					{
+						this->send(asio::error::operation_aborted, [](serializer&) {});
+					}
+					catch (std::exception&) {}
+				}
+			}
+
+			template<class Function>
+			inline bool send(const error_code& ec, Function&& fn)
+			{
+				// the one way call doesn't need the response
+				if (this->head.id() == header::id_type(0))
+					return true;
+
+				// the token is completed in any thread, so the serializer of the session can't be used
+				thread_local serializer sr;
+
+				try
+				{
+					sr.reset();
+					sr << this->head;
+					sr << ec;
+					if (!ec)
+						fn(sr);
+				}
+				catch (cereal::exception&)
+				{
+					set_last_error(asio::error::no_data);
+					return false;
+				}
+
+				return this->sender(std::string(sr.str()));
+			}
+
+			std::atomic<bool>                      done{ false };
+
+			/// the header of the response
+			header                                 head;
+
+			/// send the response by the session or the client which received the request
+			std::function<bool(std::string&&)>     sender;
+		};
+
+		template<class Function>
+		inline bool _complete(const error_code& ec, Function&& fn)
+		{
+			if (!this->state_ || this->state_->done.exchange(true, std::memory_order_acq_rel))
+				return false;
+
+			return this->state_->send(ec, std::forward<Function>(fn));
+		}
+
+		/**
+		 * @function : mark the token completed without sending anything
+		 */
+		inline void _discard()
+		{
+			if (this->state_)
+				this->state_->done.store(true, std::memory_order_release);
+		}
+
+	protected:
+		std::shared_ptr<state> state_;
+	};
+
+	template<class T>
+	struct is_rpc_response : std::false_type {};
+
+	template<class T>
+	struct is_rpc_response<rpc_response_t<T>> : std::true_type {};
+
+	template<class T>
+	inline constexpr bool is_rpc_response_v = is_rpc_response<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+}
+
+namespace asio2
+{
+	template<class T>
+	using rpc_response = detail::rpc_response_t<T>;
+}
+
+#endif // !__ASIO2_RPC_RESPONSE_HPP__
@@ -15,89 +15,36 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
-#include <istream>
-#include <ostream>
-#include <streambuf>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
 
 #include <asio2/3rd/cereal.hpp>
 
 #include <asio2/base/selector.hpp>
 #include <asio2/base/error.hpp>
 
+#include <asio2/base/detail/util.hpp>
+
 #include <asio2/rpc/detail/rpc_portable_binary.hpp>
 
 namespace asio2::detail
 {
-	class ostrbuf : public std::streambuf
-	{
-	public:
-		using string_type = std::basic_string<char_type, traits_type>;
-		using size_type = typename string_type::size_type;
-
-		ostrbuf() {}
-		virtual ~ostrbuf() {}
-
-		inline const string_type& str() const
-		{
-			return this->str_;
-		}
-
-		inline void clear()
-		{
-			this->str_.clear();
-
-			this->setp(this->str_.data(), this->str_.data() + this->str_.size());
-		}
-
-	protected:
-		virtual std::streamsize xsputn(const char_type* s, std::streamsize count) override
-		{
-			this->str_.append(s, size_type(count));
-
-			this->setp(this->str_.data(), this->str_.data() + this->str_.size());
-
-			return count;
-		}
-
-	protected:
-		string_type str_;
-	};
-
-	class istrbuf : public std::streambuf
-	{
-	public:
-		using string_type = std::basic_string<char_type, traits_type>;
-		using size_type = typename string_type::size_type;
-
-		istrbuf() {}
-		virtual ~istrbuf() {}
-
-		inline void setbuf(std::string_view s)
-		{
-			this->setbuf(const_cast<char_type*>(s.data()), std::streamsize(s.size()));
-		}
+	/// the contiguous buffers which the archives write to and read from directly, no stream is used
+	using ostrbuf = cereal::rpc_portable_binary_detail::ostrbuf;
+	using istrbuf = cereal::rpc_portable_binary_detail::istrbuf;
 
-		virtual std::streambuf* setbuf(char_type* s, std::streamsize n) override
-		{
-			this->setg(s, s, s + n);
-			return this;
-		}
-
-	protected:
-		virtual std::streamsize xsgetn(char_type* s, std::streamsize count) override
-		{
-			if (this->in_avail() < count)
-				return std::streamsize(0);
+	/// the strings and the string views of the arithmetic chars, they have the same data format
+	template<class T, class = void>
+	struct is_string_buffer : std::false_type {};
 
-			std::memcpy((void*)s, (const void*)(this->gptr()), size_type(count));
+	template<class T>
+	struct is_string_buffer<T, std::enable_if_t<(is_string_v<T> || is_string_view_v<T>) &&
+		std::is_arithmetic_v<typename T::value_type>>> : std::true_type {};
 
-			this->setg(this->eback(), this->gptr() + count, this->egptr());
-
-			return count;
-		}
-	};
+	template<class T>
+	inline constexpr bool is_string_buffer_v = is_string_buffer<T>::value;
 
 	class serializer
 	{
@@ -106,31 +53,58 @@ namespace asio2::detail
 
 		serializer()
 			: obuffer_()
-			, ostream_(&obuffer_)
-			, oarchive_(ostream_)
+			, oarchive_(obuffer_)
 		{}
 		~serializer() = default;
 
+		/**
+		 * the arithmetic values, the strings, the string views and the tuples of them are written
+		 * into the buffer directly, the other types are written by the archive, the data format is
+		 * the same, a string view is written as the string which it points to.
+		 */
 		template<typename T>
 		inline serializer& operator<<(const T& v)
 		{
-			this->oarchive_ << v;
+			if constexpr (std::is_arithmetic_v<T>)
+			{
+				this->oarchive_.template saveBinary<sizeof(T)>(std::addressof(v), sizeof(T));
+			}
+			else if constexpr (is_string_buffer_v<T>)
+			{
+				using char_type = typename T::value_type;
+				cereal::size_type size = static_cast<cereal::size_type>(v.size());
+				this->oarchive_.template saveBinary<sizeof(size)>(std::addressof(size), sizeof(size));
+				this->oarchive_.template saveBinary<sizeof(char_type)>(v.data(),
+					static_cast<std::streamsize>(v.size() * sizeof(char_type)));
+			}
+			else if constexpr (is_tuple<T>::value)
+			{
+				// the fold of the empty tuple is just (*this), which is an unused value
+				if constexpr (std::tuple_size_v<T> != 0)
+					std::apply([this](const auto&... args) { (((*this) << args), ...); }, v);
+			}
+			else
+			{
+				this->oarchive_ << v;
+			}
 			return (*this);
 		}
 
 		inline serializer& operator<<(const error_code& ec)
 		{
-			this->oarchive_ << ec.value();
-			return (*this);
+			return ((*this) << ec.value());
 		}
 
 		template<class ...Args>
 		inline serializer& save(const Args&... args)
 		{
-			((this->oarchive_ << args), ...);
+			(((*this) << args), ...);
 			return (*this);
 		}
 
+		/**
+		 * the buffer is cleared, but the memory of the buffer is reused.
+		 */
 		inline serializer& reset()
 		{
 			this->obuffer_.clear();
@@ -147,7 +121,6 @@ namespace asio2::detail
 
 	protected:
 		ostrbuf         obuffer_;
-		std::ostream    ostream_;
 		oarchive        oarchive_;
 	};
 
@@ -158,22 +131,59 @@ namespace asio2::detail
 
 		deserializer()
 			: ibuffer_()
-			, istream_(&ibuffer_)
-			, iarchive_(istream_)
+			, iarchive_(ibuffer_)
 		{}
 		~deserializer() = default;
 
+		/**
+		 * the pair of the serializer::operator<<, a string view points to the data in the buffer
+		 * directly, so it's valid only when the buffer is valid.
+		 */
 		template<typename T>
 		inline deserializer& operator>>(T& v)
 		{
-			this->iarchive_ >> v;
+			if constexpr (std::is_arithmetic_v<T>)
+			{
+				this->iarchive_.template loadBinary<sizeof(T)>(std::addressof(v), sizeof(T));
+			}
+			else if constexpr (is_string_buffer_v<T>)
+			{
+				using char_type = typename T::value_type;
+				cereal::size_type size;
+				this->iarchive_.template loadBinary<sizeof(size)>(std::addressof(size), sizeof(size));
+				// don't allocate the memory for a broken size
+				if (size > static_cast<cereal::size_type>(this->ibuffer_.in_avail()) / sizeof(char_type))
+					throw cereal::Exception("Failed to read " + std::to_string(size) + " chars from input buffer");
+				if constexpr (is_string_view_v<T>)
+				{
+					// the bytes of the wide chars may need to be swapped, so only the narrow chars can be viewed
+					static_assert(sizeof(char_type) == 1, "only the view of the narrow chars is supported");
+					v = T(reinterpret_cast<const char_type*>(this->ibuffer_.read(static_cast<std::size_t>(size))),
+						static_cast<std::size_t>(size));
+				}
+				else
+				{
+					v.resize(static_cast<std::size_t>(size));
+					this->iarchive_.template loadBinary<sizeof(char_type)>(v.data(),
+						static_cast<std::streamsize>(size * sizeof(char_type)));
+				}
+			}
+			else if constexpr (is_tuple<T>::value)
+			{
+				if constexpr (std::tuple_size_v<T> != 0)
+					std::apply([this](auto&... args) { (((*this) >> args), ...); }, v);
+			}
+			else
+			{
+				this->iarchive_ >> v;
+			}
 			return (*this);
 		}
 
 		inline deserializer& operator>>(error_code& ec)
 		{
 			decltype(ec.value()) v;
-			this->iarchive_ >> v;
+			(*this) >> v;
 			ec.assign(v, ec.category());
 			return (*this);
 		}
@@ -181,7 +191,7 @@ namespace asio2::detail
 		template<class ...Args>
 		inline deserializer& load(Args&... args)
 		{
-			((this->iarchive_ >> args), ...);
+			(((*this) >> args), ...);
 			return (*this);
 		}
 
@@ -196,7 +206,6 @@ namespace asio2::detail
 
 	protected:
 		istrbuf         ibuffer_;
-		std::istream    istream_;
 		iarchive        iarchive_;
 	};
 }
@@ -66,24 +66,20 @@ namespace asio2::detail
 
 			if /**/ (head.is_request())
 			{
+				// false if the function is deferred or called by the execution policy, the response is sent later
+				bool ready = true;
+
 				try
 				{
-					head.type(rpc_type_rep);
+					head.as_response();
 					sr.reset();
 					sr << head;
-					auto* fn = derive._invoker().find(head.name());
+					auto* fn = head.is_by_id() ?
+						derive._invoker().find(head.method()) :
+						derive._invoker().find(head.name());
 					if (fn)
 					{
-						(*fn)(this_ptr, sr, dr);
-
-						// The number of parameters passed in when calling rpc function exceeds 
-						// the number of parameters of local function
-						if (dr.buffer().in_avail() != 0 && head.id() != header::id_type(0))
-						{
-							sr.reset();
-							sr << head;
-							asio::detail::throw_error(asio::error::invalid_argument);
-						}
+						ready = derive._invoker()._execute(*fn, this_ptr, derive, head, sr, dr);
 					}
 					else
 					{
@@ -97,7 +93,7 @@ namespace asio2::detail
 				catch (system_error& e) { sr << e.code(); }
 				catch (std::exception&) { sr << error_code{ asio::error::eof }; }
 
-				if (head.id() != header::id_type(0))
+				if (ready && head.id() != header::id_type(0))
 				{
 					const std::string& str = sr.str();
 					derive.send(str);
@@ -109,6 +109,27 @@ namespace asio2::detail
 		}
 
 	protected:
+		/**
+		 * the rpc messages must be framed, so the tcp client which is started without the match
+		 * condition uses the dgram mode, otherwise the message which is larger than a read is split.
+		 */
+		template<bool isAsync, typename String, typename StrOrInt, typename MatchCondition>
+		inline bool _do_connect(String&& host, StrOrInt&& port, condition_wrap<MatchCondition> condition)
+		{
+			if constexpr (std::is_same_v<MatchCondition, asio::detail::transfer_at_least_t>)
+			{
+				detail::ignore::unused(condition);
+
+				return super::template _do_connect<isAsync>(std::forward<String>(host),
+					std::forward<StrOrInt>(port), condition_wrap<use_dgram_t>(use_dgram));
+			}
+			else
+			{
+				return super::template _do_connect<isAsync>(std::forward<String>(host),
+					std::forward<StrOrInt>(port), std::move(condition));
+			}
+		}
+
 		inline void _handle_disconnect(const error_code& ec, std::shared_ptr<derived_t> this_ptr)
 		{
 			while (!this->reqs_.empty())
@@ -215,6 +215,27 @@ namespace asio2::detail
 		}
 
 	protected:
+		/**
+		 * the rpc messages must be framed, so the tcp server which is started without the match
+		 * condition uses the dgram mode, otherwise the message which is larger than a read is split.
+		 */
+		template<typename String, typename StrOrInt, typename MatchCondition>
+		inline bool _do_start(String&& host, StrOrInt&& service, condition_wrap<MatchCondition> condition)
+		{
+			if constexpr (std::is_same_v<MatchCondition, asio::detail::transfer_at_least_t>)
+			{
+				detail::ignore::unused(condition);
+
+				return super::_do_start(std::forward<String>(host), std::forward<StrOrInt>(service),
+					condition_wrap<use_dgram_t>(use_dgram));
+			}
+			else
+			{
+				return super::_do_start(std::forward<String>(host), std::forward<StrOrInt>(service),
+					std::move(condition));
+			}
+		}
+
 		template<typename... Args>
 		inline std::shared_ptr<session_type> _make_session(Args&&... args)
 		{
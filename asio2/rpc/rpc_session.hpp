@@ -46,6 +46,7 @@ namespace asio2::detail
 	{
 		friend executor_t;
 
+		template <class>               friend class invoker_t;
 		template <class, bool>         friend class user_timer_cp;
 		template <class>               friend class post_cp;
 		template <class>               friend class data_persistence_cp;
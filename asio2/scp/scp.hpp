@@ -95,16 +95,44 @@ namespace asio2::detail
 			, event_queue_cp<derived_t>()
 			, user_data_cp<derived_t>()
 			, active_time_cp<derived_t>()
-			, user_timer_cp<derived_t, false>(iopool_.get(0))
-			, send_cp<derived_t, false>(iopool_.get(0))
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, send_cp<derived_t, false>(iopool_.get(iopool_index_))
 			, post_cp<derived_t>()
 			, tcp_send_op<derived_t, false>()
 			, tcp_recv_op<derived_t, false>()
-			, socket_(iopool_.get(0).context())
+			, socket_(iopool_.get(iopool_index_).context())
 			, rallocator_()
 			, wallocator_()
 			, listener_()
-			, io_(iopool_.get(0))
+			, io_(iopool_.get(iopool_index_))
+			, buffer_(init_buffer_size, max_buffer_size)
+		{
+		}
+
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many objects
+		 */
+		explicit scp_impl_t(
+			iopool & pool,
+			std::size_t init_buffer_size = 1024,
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: super()
+			, iopool_cp(pool)
+			, event_queue_cp<derived_t>()
+			, user_data_cp<derived_t>()
+			, active_time_cp<derived_t>()
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, send_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, post_cp<derived_t>()
+			, tcp_send_op<derived_t, false>()
+			, tcp_recv_op<derived_t, false>()
+			, socket_(iopool_.get(iopool_index_).context())
+			, rallocator_()
+			, wallocator_()
+			, listener_()
+			, io_(iopool_.get(iopool_index_))
 			, buffer_(init_buffer_size, max_buffer_size)
 		{
 		}
@@ -151,7 +179,7 @@ namespace asio2::detail
 		{
 			this->derived()._do_stop(asio::error::operation_aborted);
 
-			this->iopool_.stop();
+			this->_stop_iopool(this->io_, [this]() { return this->derived().is_stopped(); });
 		}
 
 		/**
@@ -15,8 +15,11 @@
 #pragma once
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
+#include <array>
+#include <vector>
 #include <memory>
 #include <future>
+#include <functional>
 #include <utility>
 #include <string_view>
 
@@ -24,6 +27,7 @@
 #include <asio2/base/error.hpp>
 #include <asio2/base/detail/condition_wrap.hpp>
 #include <asio2/base/detail/buffer_wrap.hpp>
+#include <asio2/base/detail/shared_buffer.hpp>
 
 namespace asio2::detail
 {
@@ -76,64 +80,142 @@ namespace asio2::detail
 		~tcp_send_op() = default;
 
 	protected:
+		/// the max count of the messages which are gathered into one write operation
+		static std::size_t constexpr tcp_gather_max_count = 64;
+
+		/// the max bytes of the messages which are gathered into one write operation
+		static std::size_t constexpr tcp_gather_max_bytes = 256 * 1024;
+
 		template<class Data, class Callback>
 		inline bool _tcp_send(Data& data, Callback&& callback)
 		{
+			bool dgram = false;
+
 			if constexpr (has_member_dgram<derived_t>::value)
 			{
-				if (derive.dgram_)
-				{
-					return derive._tcp_send_dgram(asio::buffer(data), std::forward<Callback>(callback));
-				}
+				dgram = derive.dgram_;
 			}
 			else
 			{
 				std::ignore = true;
 			}
 
+			// the dgram head of the shared buffer is made already, so send it as a general buffer.
+			if constexpr (std::is_same_v<std::remove_cv_t<Data>, shared_buffer>)
+			{
+				if (dgram)
+				{
+#if defined(ASIO2_SEND_CORE_ASYNC)
+					return derive._tcp_send_gather(data.dgram_buffer(), data.dgram_head_size(), false,
+						std::forward<Callback>(callback));
+#else
+					std::size_t head_bytes = data.dgram_head_size();
+					return derive._tcp_send_general(data.dgram_buffer(),
+						[head_bytes, &callback](const error_code& ec, std::size_t bytes_sent)
+					{
+						callback(ec, ec ? bytes_sent : bytes_sent - head_bytes);
+					});
+#endif
+				}
+			}
+
+#if defined(ASIO2_SEND_CORE_ASYNC)
+			return derive._tcp_send_gather(asio::buffer(data), 0, dgram, std::forward<Callback>(callback));
+#else
+			if (dgram)
+			{
+				return derive._tcp_send_dgram(asio::buffer(data), std::forward<Callback>(callback));
+			}
+
 			return derive._tcp_send_general(asio::buffer(data), std::forward<Callback>(callback));
+#endif
 		}
 
+#if defined(ASIO2_SEND_CORE_ASYNC)
+		/**
+		 * The front sending event of the event queue gathers the sending events which are queued
+		 * behind it, and writes all of them with one scatter/gather write operation, then the
+		 * callback of each message is called in order with its own sent bytes.
+		 */
 		template<class BufferSequence, class Callback>
-		inline bool _tcp_send_dgram(BufferSequence&& buffer, Callback&& callback)
+		inline bool _tcp_send_gather(BufferSequence&& buffer, std::size_t framed_bytes, bool dgram, Callback&& callback)
 		{
-			int bytes = 0;
-			std::unique_ptr<std::uint8_t[]> head;
+			gather_entry & entry = this->gather_entries_.emplace_back();
+
+			entry.buffer       = std::forward<BufferSequence>(buffer);
+			entry.framed_bytes = framed_bytes;
+			entry.head_bytes   = dgram ? make_dgram_head(entry.buffer.size(), entry.head.data()) : 0;
+			entry.callback     = std::forward<Callback>(callback);
+
+			this->gather_bytes_ += entry.head_bytes + entry.buffer.size();
 
-			// note : need ensure big endian and little endian
-			if (buffer.size() < std::size_t(254))
+			// this event is executed by the front event, it will be written by the front event.
+			if (this->gathering_)
+				return true;
+
+			this->gathering_ = true;
+
+			std::size_t count = derive._gather_events([this]() -> bool
+			{
+				return (this->gather_entries_.size() < tcp_gather_max_count &&
+					this->gather_bytes_ < tcp_gather_max_bytes);
+			});
+
+			this->gathering_ = false;
+
+			this->gather_buffers_.clear();
+			for (gather_entry & e : this->gather_entries_)
 			{
-				bytes = 1;
-				head = std::make_unique<std::uint8_t[]>(bytes);
-				head[0] = static_cast<std::uint8_t>(buffer.size());
+				if (e.head_bytes)
+					this->gather_buffers_.emplace_back(asio::buffer(e.head.data(), e.head_bytes));
+				this->gather_buffers_.emplace_back(e.buffer);
 			}
-			else if (buffer.size() <= (std::numeric_limits<std::uint16_t>::max)())
+
+			asio::async_write(derive.stream(), this->gather_buffers_, asio::bind_executor(derive.io().strand(),
+				make_allocator(derive.wallocator(),
+					[this, p = derive.selfptr(), count](const error_code& ec, std::size_t bytes_sent) mutable
 			{
-				bytes = 3;
-				head = std::make_unique<std::uint8_t[]>(bytes);
-				head[0] = static_cast<std::uint8_t>(254);
-				std::uint16_t size = static_cast<std::uint16_t>(buffer.size());
-				std::memcpy(&head[1], reinterpret_cast<const void*>(&size), sizeof(std::uint16_t));
-				// use little endian
-				if (!is_little_endian())
+				set_last_error(ec);
+
+				// the callbacks reference the objects which are captured by the events, so the
+				// events can't be removed until all the callbacks are called.
+				for (gather_entry & e : this->gather_entries_)
 				{
-					swap_bytes<sizeof(std::uint16_t)>(&head[1]);
+					if (ec)
+					{
+						std::size_t bytes = (std::min)(bytes_sent, e.head_bytes + e.buffer.size());
+						bytes_sent -= bytes;
+						e.callback(ec, bytes);
+					}
+					else
+					{
+						e.callback(ec, e.buffer.size() - e.framed_bytes);
+					}
 				}
-			}
-			else
-			{
-				ASIO2_ASSERT(buffer.size() > (std::numeric_limits<std::uint16_t>::max)());
-				bytes = 9;
-				head = std::make_unique<std::uint8_t[]>(bytes);
-				head[0] = static_cast<std::uint8_t>(255);
-				std::uint64_t size = buffer.size();
-				std::memcpy(&head[1], reinterpret_cast<const void*>(&size), sizeof(std::uint64_t));
-				// use little endian
-				if (!is_little_endian())
+
+				this->gather_entries_.clear();
+				this->gather_bytes_ = 0;
+
+				if (ec)
 				{
-					swap_bytes<sizeof(std::uint64_t)>(&head[1]);
+					// must stop, otherwise re-sending will cause header or body confusion
+					derive._do_disconnect(ec);
 				}
-			}
+
+				// the gathered events, the front event is removed by next_event.
+				derive._pop_events(count);
+
+				derive.next_event();
+			})));
+			return true;
+		}
+#endif
+
+		template<class BufferSequence, class Callback>
+		inline bool _tcp_send_dgram(BufferSequence&& buffer, Callback&& callback)
+		{
+			std::unique_ptr<std::uint8_t[]> head = std::make_unique<std::uint8_t[]>(dgram_head_max_size);
+			std::size_t bytes = make_dgram_head(buffer.size(), head.get());
 
 			std::array<asio::const_buffer, 2> buffers
 			{
@@ -220,6 +302,32 @@ namespace asio2::detail
 
 	protected:
 		derived_t & derive;
+
+#if defined(ASIO2_SEND_CORE_ASYNC)
+		struct gather_entry
+		{
+			asio::const_buffer                                 buffer;
+
+			/// the bytes of the dgram head which is in front of the buffer already
+			std::size_t                                        framed_bytes = 0;
+
+			/// the bytes of the dgram head which is written before the buffer
+			std::size_t                                        head_bytes = 0;
+
+			std::array<std::uint8_t, dgram_head_max_size>      head;
+
+			std::function<void(const error_code&, std::size_t)> callback;
+		};
+
+		/// whether the front event is gathering the sending events behind it
+		bool                                gathering_    = false;
+
+		std::size_t                         gather_bytes_ = 0;
+
+		std::vector<gather_entry>           gather_entries_;
+
+		std::vector<asio::const_buffer>     gather_buffers_;
+#endif
 	};
 }
 
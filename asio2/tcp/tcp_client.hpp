@@ -64,6 +64,22 @@ namespace asio2::detail
 		{
 		}
 
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many clients
+		 */
+		explicit tcp_client_impl_t(
+			iopool & pool,
+			std::size_t init_buffer_size = tcp_frame_size,
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: super(pool, init_buffer_size, max_buffer_size)
+			, tcp_keepalive_cp<socket_t>(this->socket_)
+			, tcp_send_op<derived_t, false>()
+			, tcp_recv_op<derived_t, false>()
+		{
+		}
+
 		/**
 		 * @destructor
 		 */
@@ -160,7 +176,7 @@ namespace asio2::detail
 			// This will result in an ungraceful close.
 			this->derived()._do_stop(asio::error::operation_aborted);
 
-			this->iopool_.stop();
+			this->_stop_iopool(this->io_, [this]() { return this->derived().is_stopped(); });
 		}
 
 	public:
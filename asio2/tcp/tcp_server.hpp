@@ -20,6 +20,49 @@
 
 namespace asio2::detail
 {
+	/**
+	 * A SO_REUSEPORT listening socket which is running on its own io_context.
+	 */
+	struct tcp_reuse_acceptor
+	{
+		explicit tcp_reuse_acceptor(io_t & io, std::shared_ptr<void> counter_ptr)
+			: io_(io)
+			, acceptor_(io.context())
+			, acceptor_timer_(io.context())
+			, rallocator_()
+			, counter_ptr_(std::move(counter_ptr))
+		{
+		}
+
+		/// the io_context which the acceptor and the accepted sessions are running on
+		io_t                    & io_;
+
+		/// acceptor to accept client connection
+		asio::ip::tcp::acceptor   acceptor_;
+
+		/// timer for acceptor exception, like the exception "Too many open files" (exception code : 24)
+		asio::steady_timer        acceptor_timer_;
+
+		/// the memory to be used for the accept handler
+		handler_memory<>          rallocator_;
+
+		/// the server's counter, it's only accessed in the io_context thread of this acceptor
+		std::shared_ptr<void>     counter_ptr_;
+	};
+
+	/**
+	 * The references of a listening socket and its io_context, the first acceptor of the server
+	 * and the SO_REUSEPORT acceptors are accepted by the same functions through it.
+	 */
+	struct tcp_acceptor_ref
+	{
+		io_t                    & io_;
+		asio::ip::tcp::acceptor & acceptor_;
+		asio::steady_timer      & acceptor_timer_;
+		handler_memory<>        & rallocator_;
+		std::shared_ptr<void>   & counter_ptr_;
+	};
+
 	template<class derived_t, class session_t>
 	class tcp_server_impl_t : public server_impl_t<derived_t, session_t>
 	{
@@ -31,6 +74,7 @@ namespace asio2::detail
 		using self = tcp_server_impl_t<derived_t, session_t>;
 		using super = server_impl_t<derived_t, session_t>;
 		using session_type = session_t;
+		using reuse_acceptor = tcp_reuse_acceptor;
 
 		/**
 		 * @constructor
@@ -255,6 +299,25 @@ namespace asio2::detail
 		 */
 		inline asio::ip::tcp::acceptor & acceptor() { return this->acceptor_; }
 
+		/**
+		 * @function : set whether open a SO_REUSEPORT listening socket for each io_context of the
+		 * iopool, each listening socket accepts the connections on its own io_context thread, and
+		 * the accepted session runs on the same io_context, the kernel distributes the incoming
+		 * connections across the listening sockets. It must be called before the server starts.
+		 * If the SO_REUSEPORT option is not supported by the platform, only one listening socket
+		 * is opened as usual.
+		 */
+		inline derived_t & reuse_port(bool enable)
+		{
+			this->reuse_port_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the SO_REUSEPORT multi listening sockets mode is enabled
+		 */
+		inline bool is_reuse_port() const { return this->reuse_port_; }
+
 	protected:
 		template<typename String, typename StrOrInt, typename MatchCondition>
 		bool _do_start(String&& host, StrOrInt&& service, condition_wrap<MatchCondition> condition)
@@ -292,6 +355,10 @@ namespace asio2::detail
 
 				this->acceptor_.close(ec_ignore);
 
+				// the iopool was stopped already, so all the handlers of the reuse port acceptors
+				// have completed, and it's safe to destroy them at here.
+				this->reuse_acceptors_.clear();
+
 				std::string h = to_string(std::forward<String>(host));
 				std::string p = to_string(std::forward<StrOrInt>(service));
 
@@ -308,17 +375,54 @@ namespace asio2::detail
 				// seconds later,so we can use the SO_REUSEADDR option to avoid this problem,like below
 				this->acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true)); // set port reuse
 
+			#if defined(SO_REUSEPORT)
+				if (this->reuse_port_)
+					this->acceptor_.set_option(socket_reuse_port(true));
+			#endif
+
 				this->derived()._fire_init();
 
 				this->acceptor_.bind(endpoint);
 				this->acceptor_.listen();
 
+			#if defined(SO_REUSEPORT)
+				if (this->reuse_port_)
+				{
+					// the service maybe "0", so we use the real listening endpoint of the first acceptor.
+					endpoint = this->acceptor_.local_endpoint();
+
+					// the first acceptor is running on the io_, open the others on the rest io_contexts.
+					for (std::size_t i = 1; i < this->iopool_.size(); ++i)
+					{
+						auto ra = std::make_unique<reuse_acceptor>(this->iopool_.get(i), this->counter_ptr_);
+
+						ra->acceptor_.open(endpoint.protocol());
+						ra->acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+						ra->acceptor_.set_option(socket_reuse_port(true));
+						ra->acceptor_.bind(endpoint);
+						ra->acceptor_.listen();
+
+						this->reuse_acceptors_.emplace_back(std::move(ra));
+					}
+				}
+			#endif
+
 				this->derived()._handle_start(error_code{}, std::move(condition));
 
 				return (this->is_started());
 			}
 			catch (system_error & e)
 			{
+				// a reuse port acceptor failed to open, the opened ones have no pending operations
+				// yet, so close them and release their copies of the counter at here, otherwise the
+				// server never reaches the stopped state.
+				for (auto & ra : this->reuse_acceptors_)
+				{
+					ra->acceptor_.close(ec_ignore);
+					ra->counter_ptr_.reset();
+				}
+				this->reuse_acceptors_.clear();
+
 				this->derived()._handle_start(e.code(), std::move(condition));
 			}
 			return false;
@@ -348,8 +452,16 @@ namespace asio2::detail
 
 				asio::post(this->io_.strand(), [this, condition]()
 				{
-					this->derived()._post_accept(std::move(condition));
+					this->derived()._post_accept(this->_acceptor_ref(), std::move(condition));
 				});
+
+				for (auto & ra : this->reuse_acceptors_)
+				{
+					asio::post(ra->io_.strand(), [this, ra = ra.get(), condition]()
+					{
+						this->derived()._post_accept(this->_acceptor_ref(*ra), std::move(condition));
+					});
+				}
 			}
 			catch (system_error & e)
 			{
@@ -388,6 +500,23 @@ namespace asio2::detail
 					session_ptr->stop();
 				});
 
+				// the reuse port acceptors must be closed in their own io_context thread.
+				for (auto & ra : this->reuse_acceptors_)
+				{
+					asio::post(ra->io_.strand(), [ra = ra.get()]()
+					{
+						try
+						{
+							ra->acceptor_timer_.cancel();
+						}
+						catch (system_error &) {}
+
+						ra->acceptor_.close(ec_ignore);
+
+						ra->counter_ptr_.reset();
+					});
+				}
+
 				this->counter_ptr_.reset();
 			});
 		}
@@ -419,13 +548,50 @@ namespace asio2::detail
 		inline std::shared_ptr<session_t> _make_session(Args&&... args)
 		{
 			return std::make_shared<session_t>(std::forward<Args>(args)..., this->sessions_, this->listener_,
-				this->iopool_.get(), this->init_buffer_size_, this->max_buffer_size_);
+				this->_session_io(), this->init_buffer_size_, this->max_buffer_size_);
 		}
 
+		/**
+		 * @function : get the io_context for the new session, in reuse port mode, the session uses the
+		 * io_context of the acceptor which is accepting it, so the session never hops threads.
+		 */
+		inline io_t & _session_io()
+		{
+			if (!this->reuse_acceptors_.empty())
+			{
+				if (this->io_.strand().running_in_this_thread())
+					return this->io_;
+
+				for (auto & ra : this->reuse_acceptors_)
+				{
+					if (ra->io_.strand().running_in_this_thread())
+						return ra->io_;
+				}
+			}
+			return this->iopool_.get();
+		}
+
+		/**
+		 * @function : get the references of the first acceptor or a reuse port acceptor
+		 */
+		inline tcp_acceptor_ref _acceptor_ref()
+		{
+			return tcp_acceptor_ref{ this->io_, this->acceptor_, this->acceptor_timer_,
+				this->rallocator_, this->counter_ptr_ };
+		}
+
+		inline tcp_acceptor_ref _acceptor_ref(reuse_acceptor & ra)
+		{
+			return tcp_acceptor_ref{ ra.io_, ra.acceptor_, ra.acceptor_timer_, ra.rallocator_, ra.counter_ptr_ };
+		}
+
+		/**
+		 * @function : post an accept on the acceptor, it's called in the strand of the io of the acceptor
+		 */
 		template<typename MatchCondition>
-		inline void _post_accept(condition_wrap<MatchCondition> condition)
+		inline void _post_accept(tcp_acceptor_ref ref, condition_wrap<MatchCondition> condition)
 		{
-			if (!this->is_started())
+			if (!this->is_started() || !ref.acceptor_.is_open())
 				return;
 
 			try
@@ -433,11 +599,11 @@ namespace asio2::detail
 				std::shared_ptr<session_t> session_ptr = this->derived()._make_session();
 
 				auto & socket = session_ptr->socket().lowest_layer();
-				this->acceptor_.async_accept(socket, asio::bind_executor(this->io_.strand(),
-					make_allocator(this->rallocator_,
-						[this, sptr = std::move(session_ptr), condition](const error_code & ec)
+				ref.acceptor_.async_accept(socket, asio::bind_executor(ref.io_.strand(),
+					make_allocator(ref.rallocator_,
+						[this, ref, sptr = std::move(session_ptr), condition](const error_code & ec)
 				{
-					this->derived()._handle_accept(ec, std::move(sptr), std::move(condition));
+					this->derived()._handle_accept(ec, ref, std::move(sptr), std::move(condition));
 				})));
 			}
 			// handle exception,may be is the exception "Too many open files" (exception code : 24)
@@ -445,22 +611,22 @@ namespace asio2::detail
 			{
 				set_last_error(e);
 
-				this->acceptor_timer_.expires_after(std::chrono::seconds(1));
-				this->acceptor_timer_.async_wait(asio::bind_executor(this->io_.strand(),
-					make_allocator(this->rallocator_, [this, condition](const error_code & ec)
+				ref.acceptor_timer_.expires_after(std::chrono::seconds(1));
+				ref.acceptor_timer_.async_wait(asio::bind_executor(ref.io_.strand(),
+					make_allocator(ref.rallocator_, [this, ref, condition](const error_code & ec)
 				{
 					set_last_error(ec);
 					if (ec) return;
-					asio::post(this->io_.strand(), make_allocator(this->rallocator_, [this, condition]()
+					asio::post(ref.io_.strand(), make_allocator(ref.rallocator_, [this, ref, condition]()
 					{
-						this->derived()._post_accept(std::move(condition));
+						this->derived()._post_accept(ref, std::move(condition));
 					}));
 				})));
 			}
 		}
 
 		template<typename MatchCondition>
-		inline void _handle_accept(const error_code & ec, std::shared_ptr<session_t> session_ptr,
+		inline void _handle_accept(const error_code & ec, tcp_acceptor_ref ref, std::shared_ptr<session_t> session_ptr,
 			condition_wrap<MatchCondition> condition)
 		{
 			set_last_error(ec);
@@ -474,14 +640,15 @@ namespace asio2::detail
 
 			if (!ec)
 			{
-				if (this->is_started())
+				// the counter is reset in the strand of the acceptor when the server is stopping
+				if (this->is_started() && ref.counter_ptr_)
 				{
-					session_ptr->counter_ptr_ = this->counter_ptr_;
+					session_ptr->counter_ptr_ = ref.counter_ptr_;
 					session_ptr->start(condition);
 				}
 			}
 
-			this->derived()._post_accept(std::move(condition));
+			this->derived()._post_accept(ref, std::move(condition));
 		}
 
 		inline void _fire_init()
@@ -512,6 +679,12 @@ namespace asio2::detail
 		std::size_t             init_buffer_size_ = tcp_frame_size;
 
 		std::size_t             max_buffer_size_ = (std::numeric_limits<std::size_t>::max)();
+
+		/// whether open a SO_REUSEPORT listening socket for each io_context
+		bool                    reuse_port_ = false;
+
+		/// the SO_REUSEPORT listening sockets which are running on the other io_contexts
+		std::vector<std::unique_ptr<reuse_acceptor>> reuse_acceptors_;
 	};
 }
 
@@ -66,6 +66,22 @@ namespace asio2::detail
 		{
 		}
 
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many clients
+		 */
+		explicit tcps_client_impl_t(
+			iopool & pool,
+			asio::ssl::context::method method = asio::ssl::context::sslv23,
+			std::size_t init_buffer_size = tcp_frame_size,
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: ssl_context_comp(method)
+			, super(pool, init_buffer_size, max_buffer_size)
+			, ssl_stream_comp(this->io_, *this, asio::ssl::stream_base::client)
+		{
+		}
+
 		/**
 		 * @destructor
 		 */
@@ -25,16 +25,22 @@
 #include <asio2/base/detail/allocator.hpp>
 #include <asio2/base/detail/util.hpp>
 #include <asio2/base/detail/buffer_wrap.hpp>
+#include <asio2/base/detail/timer_wheel.hpp>
 
 #include <asio2/udp/detail/kcp_util.hpp>
+#include <asio2/udp/detail/kcp_fec.hpp>
+#include <asio2/udp/detail/kcp_cookie.hpp>
+#include <asio2/udp/detail/udp_mmsg.hpp>
 
 namespace asio2::detail
 {
 	/*
-	 * because udp is connectionless, in order to simplify the code logic, KCP shakes
-	 * hands only twice (compared with TCP handshakes three times)
+	 * because udp is connectionless, the server replies the syn statelessly, and the session
+	 * is created only when the client echoes the cookie, so the syn flood allocates nothing.
 	 * 1 : client send syn to server
-	 * 2 : server send synack to client
+	 * 2 : server send synack which carries the cookie to client, the cookie is the conv
+	 * 3 : client send ack which carries the cookie to server, and resend it until confirmed
+	 * 4 : server create the session and send the ack to client as the confirmation
 	 */
 	template<class derived_t, bool isSession>
 	class kcp_stream_cp
@@ -48,8 +54,9 @@ namespace asio2::detail
 		 * @constructor
 		 */
 		kcp_stream_cp(derived_t & d, io_t & io)
-			: derive(d), kcp_io_(io), kcp_timer_(io.context())
+			: derive(d), kcp_io_(io)
 		{
+			kcp::kcp_install_allocator();
 		}
 
 		/**
@@ -76,8 +83,7 @@ namespace asio2::detail
 			this->kcp_ = kcp::ikcp_create(conv, (void*)this);
 			this->kcp_->output = &kcp_stream_cp<derived_t, isSession>::_kcp_output;
 
-			kcp::ikcp_nodelay(this->kcp_, 1, 10, 2, 1);
-			kcp::ikcp_wndsize(this->kcp_, 128, 512);
+			this->_kcp_apply_option();
 
 			this->_post_kcp_timer(std::move(this_ptr));
 		}
@@ -86,15 +92,166 @@ namespace asio2::detail
 		{
 			detail::ignore::unused(this_ptr);
 
+			// the kcp segments and the datagrams which are queued in the sender of this thread must be
+			// sent before the FIN, otherwise the FIN may overtake them.
+			if (this->kcp_)
+				kcp::ikcp_flush(this->kcp_);
+			if (this->fec_)
+				this->fec_->flush([this](std::string_view s) { this->_kcp_push(s); });
+			udp_mmsg_sender::this_thread_sender().flush();
+
 			error_code ec;
 			// if is kcp mode, send FIN handshake before close
 			if (this->send_fin_)
 				this->_kcp_send_hdr(kcp::make_kcphdr_fin(0), ec);
 
-			this->kcp_timer_.cancel();
+			this->_stop_ack_timer();
+
+			this->_stop_kcp_timer();
+		}
+
+		/**
+		 * @function : send the ack of the handshake to the server, and resend it until the server
+		 * confirms it, just used for the client.
+		 */
+		inline void _post_ack_timer(kcp::kcphdr ack)
+		{
+			error_code ec;
+			this->_kcp_send_hdr(ack, ec);
+
+			this->ack_timer_ = mktimer(derive.io(), std::chrono::milliseconds(500),
+				[this, ack, deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5)](error_code ec)
+			{
+				if (ec == asio::error::operation_aborted || std::chrono::steady_clock::now() > deadline)
+					return false;
+				this->_kcp_send_hdr(ack, ec);
+				return !ec;
+			});
+		}
+
+		inline void _stop_ack_timer()
+		{
+			if (this->ack_timer_)
+			{
+				try
+				{
+					this->ack_timer_->cancel();
+				}
+				catch (system_error &) {}
+
+				this->ack_timer_.reset();
+			}
+		}
+
+	protected:
+		/**
+		 * @function : get the kcp options
+		 */
+		inline kcp_option _get_option() const
+		{
+			return this->option_;
+		}
+
+		/**
+		 * @function : change the kcp options at runtime, it's applied in the io thread.
+		 */
+		inline void _set_option(const kcp_option & opt)
+		{
+			if (this->kcp_io_.strand().running_in_this_thread())
+			{
+				this->option_ = opt;
+				if (this->kcp_)
+					this->_kcp_apply_option();
+				return;
+			}
+
+			try
+			{
+				asio::post(this->kcp_io_.strand(), make_allocator(this->tallocator_,
+					[this, opt, self_ptr = derive.selfptr()]()
+				{
+					this->_set_option(opt);
+				}));
+			}
+			catch (system_error &) {}
+			catch (std::exception &) {}
+		}
+
+		/**
+		 * @function : get the transport statistics, it's refreshed by each update of the kcp.
+		 */
+		inline kcp::kcp_stats _get_stats() const
+		{
+			kcp::kcp_stats stats;
+			stats.srtt             = this->stats_[0 ].load(std::memory_order_relaxed);
+			stats.rttvar           = this->stats_[1 ].load(std::memory_order_relaxed);
+			stats.rto              = this->stats_[2 ].load(std::memory_order_relaxed);
+			stats.retransmits      = this->stats_[3 ].load(std::memory_order_relaxed);
+			stats.fast_retransmits = this->stats_[4 ].load(std::memory_order_relaxed);
+			stats.inflight         = this->stats_[5 ].load(std::memory_order_relaxed);
+			stats.snd_queue        = this->stats_[6 ].load(std::memory_order_relaxed);
+			stats.rcv_queue        = this->stats_[7 ].load(std::memory_order_relaxed);
+			stats.rcv_buf          = this->stats_[8 ].load(std::memory_order_relaxed);
+			stats.cwnd             = this->stats_[9 ].load(std::memory_order_relaxed);
+			stats.rmt_wnd          = this->stats_[10].load(std::memory_order_relaxed);
+			return stats;
 		}
 
 	protected:
+		inline void _kcp_apply_option()
+		{
+			const kcp_option & opt = this->option_;
+
+			kcp::ikcp_nodelay(this->kcp_, opt.nodelay, opt.interval, opt.resend, opt.nc);
+			kcp::ikcp_wndsize(this->kcp_, opt.sndwnd, opt.rcvwnd);
+
+			// the fec header is added to each kcp datagram, so reduce the mtu of the kcp
+			kcp::ikcp_setmtu(this->kcp_, opt.mtu - static_cast<int>(this->fec_ ? kcp::fec_overhead : 0));
+
+			if (opt.minrto > 0)
+				this->kcp_->rx_minrto = opt.minrto;
+		}
+
+		/// the stats are read by the other threads, so they are copied into the atomic variables
+		inline void _kcp_update_stats()
+		{
+			const kcp::ikcpcb * k = this->kcp_;
+			this->stats_[0 ].store(static_cast<std::uint32_t>(k->rx_srtt  ), std::memory_order_relaxed);
+			this->stats_[1 ].store(static_cast<std::uint32_t>(k->rx_rttval), std::memory_order_relaxed);
+			this->stats_[2 ].store(static_cast<std::uint32_t>(k->rx_rto   ), std::memory_order_relaxed);
+			this->stats_[3 ].store(k->xmit     , std::memory_order_relaxed);
+			this->stats_[4 ].store(k->fast_xmit, std::memory_order_relaxed);
+			this->stats_[5 ].store(k->nsnd_buf , std::memory_order_relaxed);
+			this->stats_[6 ].store(k->nsnd_que , std::memory_order_relaxed);
+			this->stats_[7 ].store(k->nrcv_que , std::memory_order_relaxed);
+			this->stats_[8 ].store(k->nrcv_buf , std::memory_order_relaxed);
+			this->stats_[9 ].store(k->cwnd     , std::memory_order_relaxed);
+			this->stats_[10].store(k->rmt_wnd  , std::memory_order_relaxed);
+		}
+
+		/**
+		 * enable the forward error correction with the negotiated shards, it must be called before
+		 * the kcp is started.
+		 */
+		inline void _fec_start(std::uint8_t data_shards, std::uint8_t parity_shards)
+		{
+			if (data_shards > 0 && parity_shards > 0 &&
+				data_shards <= kcp::fec_max_shards && parity_shards <= kcp::fec_max_shards)
+				this->fec_ = std::make_unique<kcp::fec_codec>(data_shards, parity_shards);
+			else
+				this->fec_.reset();
+		}
+
+		inline std::uint8_t _fec_data_shards() const
+		{
+			return this->fec_ ? static_cast<std::uint8_t>(this->fec_->data_shards()) : std::uint8_t(0);
+		}
+
+		inline std::uint8_t _fec_parity_shards() const
+		{
+			return this->fec_ ? static_cast<std::uint8_t>(this->fec_->parity_shards()) : std::uint8_t(0);
+		}
+
 		inline std::size_t _kcp_send_hdr(kcp::kcphdr hdr, error_code& ec)
 		{
 			std::size_t sent_bytes = 0;
@@ -117,6 +274,7 @@ namespace asio2::detail
 			set_last_error(ret);
 			if (ret == 0)
 				kcp::ikcp_flush(this->kcp_);
+			udp_mmsg_sender::this_thread_sender().flush();
 			callback(get_last_error(), ret < 0 ? 0 : buffer.size());
 
 #if defined(ASIO2_SEND_CORE_ASYNC)
@@ -126,19 +284,33 @@ namespace asio2::detail
 			return (ret == 0);
 		}
 
+		/**
+		 * the kcp sessions of an io are updated by the 1ms kcp wheel of the io, each session is linked
+		 * into the slot of its next ikcp_check deadline, so all the due sessions are updated in one
+		 * tick of the wheel, and their output datagrams are sent by one flush of the sender.
+		 */
 		inline void _post_kcp_timer(std::shared_ptr<derived_t> this_ptr)
 		{
+			// the timer wheel can only be used in the strand of the io
+			if (!this->kcp_io_.strand().running_in_this_thread())
+			{
+				asio::post(this->kcp_io_.strand(), make_allocator(this->tallocator_,
+					[this, self_ptr = std::move(this_ptr)]() mutable
+				{
+					this->_post_kcp_timer(std::move(self_ptr));
+				}));
+				return;
+			}
+
 			std::uint32_t clock1 = static_cast<std::uint32_t>(std::chrono::duration_cast<
 				std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 			std::uint32_t clock2 = kcp::ikcp_check(this->kcp_, clock1);
 
-			this->kcp_timer_.expires_after(std::chrono::milliseconds(clock2 - clock1));
-			this->kcp_timer_.async_wait(asio::bind_executor(this->kcp_io_.strand(),
-				make_allocator(this->tallocator_,
-					[this, self_ptr = std::move(this_ptr)](const error_code & ec)
+			this->kcp_io_.kcp_wheel().start(this->kcp_timer_, std::chrono::milliseconds(clock2 - clock1),
+				[this, self_ptr = std::move(this_ptr)]() mutable
 			{
-				this->_handle_kcp_timer(ec, std::move(self_ptr));
-			})));
+				this->_handle_kcp_timer(error_code{}, std::move(self_ptr));
+			});
 		}
 
 		inline void _handle_kcp_timer(const error_code & ec, std::shared_ptr<derived_t> this_ptr)
@@ -148,14 +320,54 @@ namespace asio2::detail
 			std::uint32_t clock = static_cast<std::uint32_t>(std::chrono::duration_cast<
 				std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 			kcp::ikcp_update(this->kcp_, clock);
+			if (this->fec_)
+				this->fec_->tick([this](std::string_view s) { this->_kcp_push(s); });
+			udp_mmsg_sender::this_thread_sender().post_flush(this->kcp_io_.strand());
+			this->_kcp_update_stats();
 			if (derive.is_started())
 				this->_post_kcp_timer(std::move(this_ptr));
 		}
 
+		inline void _stop_kcp_timer()
+		{
+			if (this->kcp_io_.strand().running_in_this_thread())
+			{
+				this->kcp_io_.kcp_wheel().cancel(this->kcp_timer_);
+				return;
+			}
+
+			try
+			{
+				asio::post(this->kcp_io_.strand(), make_allocator(this->tallocator_,
+					[this, self_ptr = derive.selfptr()]()
+				{
+					this->kcp_io_.kcp_wheel().cancel(this->kcp_timer_);
+				}));
+			}
+			catch (system_error &) {}
+			catch (std::exception &) {}
+		}
+
+		/**
+		 * the output datagrams are collected by the udp_mmsg_sender of this thread, the caller
+		 * must flush the sender when the handler run ends.
+		 */
 		template<class buffer_t>
 		inline void _kcp_recv(std::shared_ptr<derived_t>& this_ptr, std::string_view s, buffer_t& buffer)
 		{
-			int len = kcp::ikcp_input(this->kcp_, (const char *)s.data(), (long)s.size());
+			int len = 0;
+			if (this->fec_)
+			{
+				// the data shard is input immediately, the recovered data shards are input too.
+				len = this->fec_->decode(s, [this](const char * data, std::size_t size)
+				{
+					return kcp::ikcp_input(this->kcp_, data, (long)size);
+				});
+			}
+			else
+			{
+				len = kcp::ikcp_input(this->kcp_, (const char *)s.data(), (long)s.size());
+			}
 			buffer.consume(buffer.size());
 			if (len != 0)
 			{
@@ -165,20 +377,24 @@ namespace asio2::detail
 			}
 			for (;;)
 			{
+				int size = kcp::ikcp_peeksize(this->kcp_);
+				if (size < 0)
+					break;
+
+				// grow the buffer to the message size at once, the buffer is reused by the following
+				// messages, so it's not reallocated again unless a larger message is arrived.
+				if (static_cast<std::size_t>(size) > buffer.pre_size())
+					buffer.pre_size(static_cast<std::size_t>(size));
+
 				len = kcp::ikcp_recv(this->kcp_, (char *)buffer.prepare(
 					buffer.pre_size()).data(), (int)buffer.pre_size());
-				if /**/ (len >= 0)
-				{
-					buffer.commit(len);
-					derive._fire_recv(this_ptr, std::string_view(static_cast
-						<std::string_view::const_pointer>(buffer.data().data()), len));
-					buffer.consume(len);
-				}
-				else if (len == -3)
-				{
-					buffer.pre_size(buffer.pre_size() * 2);
-				}
-				else break;
+				if (len < 0)
+					break;
+
+				buffer.commit(len);
+				derive._fire_recv(this_ptr, std::string_view(static_cast
+					<std::string_view::const_pointer>(buffer.data().data()), len));
+				buffer.consume(len);
 			}
 			kcp::ikcp_flush(this->kcp_);
 		}
@@ -191,16 +407,22 @@ namespace asio2::detail
 				error_code ec;
 				if constexpr (isSession)
 				{
-					// step 3 : server recvd syn from client (the first_ is the syn)
-
-					// step 4 : server send synack to client
-					kcp::kcphdr * hdr = (kcp::kcphdr*)(derive.first_.data());
-					const auto & key = derive.hash_key();
-					std::uint32_t conv = fnv1a_hash<std::uint32_t>(
-						(const unsigned char * const)&key, std::uint32_t(sizeof(key)));
+					// step 4 : server recvd the cookie from client (the first_ is the ack or the kcp data)
+					std::uint32_t conv = 0;
+					kcp::kcp_cookie::parse(derive.first_, conv);
 					this->seq_ = conv;
-					kcp::kcphdr synack = kcp::make_kcphdr_synack(this->seq_, hdr->th_seq);
-					this->_kcp_send_hdr(synack, ec);
+
+					// the seq of the syn is used to recognize the resent syn, it's unknown if the ack is lost
+					if (derive.first_.size() == sizeof(kcp::kcphdr))
+						this->syn_seq_ = ((kcp::kcphdr*)(derive.first_.data()))->th_seq;
+
+					// the fec shards negotiated by the synack are carried by the cookie
+					this->option_ = condition.kcp().kcp_opt;
+					if (kcp::kcp_cookie::fec_data(conv) > 0 && kcp::kcp_cookie::fec_parity(conv) > 0)
+						this->_fec_start(kcp::kcp_cookie::fec_data(conv), kcp::kcp_cookie::fec_parity(conv));
+
+					// send the confirmation of the ack to client
+					this->_kcp_send_hdr(kcp::make_kcphdr_ack(this->seq_), ec);
 					asio::detail::throw_error(ec);
 
 					this->_kcp_start(self_ptr, this->seq_);
@@ -211,7 +433,10 @@ namespace asio2::detail
 					// step 1 : client send syn to server
 					this->seq_ = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
 						std::chrono::system_clock::now().time_since_epoch()).count());
-					kcp::kcphdr syn = kcp::make_kcphdr_syn(this->seq_);
+					this->option_ = condition.kcp().kcp_opt;
+
+					kcp::kcphdr syn = kcp::make_kcphdr_syn(this->seq_,
+						condition.kcp().fec_data_shards, condition.kcp().fec_parity_shards);
 					this->_kcp_send_hdr(syn, ec);
 					asio::detail::throw_error(ec);
 
@@ -257,8 +482,14 @@ namespace asio2::detail
 						// Check whether the data is the correct handshake information
 						if (kcp::is_kcphdr_synack(s, this->seq_))
 						{
-							std::uint32_t conv = ((kcp::kcphdr*)(s.data()))->th_seq;
-							this->_kcp_start(this_ptr, conv);
+							kcp::kcphdr * hdr = (kcp::kcphdr*)(s.data());
+							this->_fec_start(static_cast<std::uint8_t>(hdr->th_fec_data),
+								static_cast<std::uint8_t>(hdr->th_fec_parity));
+
+							// step 3 : client send ack which carries the cookie and the seq of the syn to server
+							this->_post_ack_timer(kcp::make_kcphdr_ack(hdr->th_seq, this->seq_));
+
+							this->_kcp_start(this_ptr, hdr->th_seq);
 							this->_handle_handshake(ec, std::move(this_ptr), condition);
 						}
 						else
@@ -313,18 +544,26 @@ namespace asio2::detail
 
 			kcp_stream_cp * zhis = ((kcp_stream_cp*)user);
 
-			derived_t & derive = zhis->derive;
-
-			error_code ec;
-			if constexpr (isSession)
-				derive.stream().send_to(asio::buffer(buf, len),
-					derive.remote_endpoint_, 0, ec);
+			if (zhis->fec_)
+				zhis->fec_->encode(buf, static_cast<std::size_t>(len), [zhis](std::string_view s)
+				{
+					zhis->_kcp_push(s);
+				});
 			else
-				derive.stream().send(asio::buffer(buf, len), 0, ec);
+				zhis->_kcp_push(std::string_view(buf, len));
 
 			return 0;
 		}
 
+		/// the datagrams are sent by one sendmmsg call when the handler run ends.
+		inline void _kcp_push(std::string_view s)
+		{
+			if constexpr (isSession)
+				udp_mmsg_sender::this_thread_sender().push(derive.stream(), &(derive.remote_endpoint_), s, derive.gso_);
+			else
+				udp_mmsg_sender::this_thread_sender().push(derive.stream(), nullptr, s, derive.gso_);
+		}
+
 	protected:
 		derived_t                   & derive;
 
@@ -334,11 +573,24 @@ namespace asio2::detail
 
 		std::uint32_t                 seq_ = 0;
 
+		/// the seq of the syn of the client, just used for the session
+		std::uint32_t                 syn_seq_ = 0;
+
 		bool                          send_fin_ = true;
 
+		/// the forward error correction, it's nullptr when the fec is not negotiated
+		std::unique_ptr<kcp::fec_codec> fec_;
+
+		kcp_option                    option_;
+
+		std::atomic<std::uint32_t>    stats_[11] = {};
+
 		handler_memory<>              tallocator_;
 
-		asio::steady_timer            kcp_timer_;
+		timer_wheel::timer            kcp_timer_;
+
+		/// resend the ack of the handshake until it's confirmed, just used for the client
+		std::shared_ptr<asio::steady_timer> ack_timer_;
 	};
 }
 
@@ -0,0 +1,268 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_UDP_BATCH_COMPONENT_HPP__
+#define __ASIO2_UDP_BATCH_COMPONENT_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/iopool.hpp>
+#include <asio2/base/error.hpp>
+
+#include <asio2/base/detail/util.hpp>
+
+#include <asio2/udp/detail/udp_mmsg.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * The timed batching of the udp sends, the small messages which are sent in the batch window
+	 * are packed into one datagram, the datagram is made up of :
+	 * | magic (2) | len (2) msg | len (2) msg | ...
+	 * the integers are little endian. The datagram is sent when it's full or when the first message
+	 * of it has waited for the max delay. The receiver must enable the batching too, then the packed
+	 * datagram is split into the messages before they are passed to the recv listener.
+	 * It's not used for the kcp mode, the kcp has its own packing.
+	 */
+	template<class derived_t, bool isSession>
+	class udp_batch_cp
+	{
+	public:
+		static constexpr std::uint16_t batch_magic = 0xA2B6;
+
+		static constexpr std::size_t   batch_header_size = 2;
+
+		/// the max payload of the udp datagram
+		static constexpr std::size_t   batch_max_datagram = 65507;
+
+	public:
+		/**
+		 * @constructor
+		 */
+		udp_batch_cp(io_t & io) : derive(static_cast<derived_t&>(*this)), batch_timer_(io.context()) {}
+
+		/**
+		 * @destructor
+		 */
+		~udp_batch_cp() = default;
+
+	public:
+		/**
+		 * @function : enable the batching of the sends, this function should be called before start.
+		 * @param    : delay - the max time which a message waits in the batch
+		 * @param    : max_size - the max size of the packed datagram, 0 means disable the batching.
+		 * The packed datagram is truncated if it's greater than the recv buffer size of the peer, the
+		 * peer is assumed to have the same recv buffer size as this side, so the max_size is clamped
+		 * to the recv buffer size.
+		 */
+		template<class Rep, class Period>
+		inline derived_t & batch_window(std::chrono::duration<Rep, Period> delay, std::size_t max_size = udp_frame_size)
+		{
+			ASIO2_ASSERT(max_size <= this->_batch_recv_size());
+
+			this->batch_delay_ = (std::max)(std::chrono::duration_cast<std::chrono::microseconds>(delay),
+				std::chrono::microseconds(0));
+			this->batch_size_ = max_size == 0 ? 0 : (std::min)((std::max)((std::min)(max_size,
+				this->_batch_recv_size()), batch_header_size + 2 + 1), batch_max_datagram);
+			return (this->derive);
+		}
+
+		/**
+		 * @function : check whether the batching is enabled
+		 */
+		inline bool is_batch() const { return (this->batch_size_ != 0); }
+
+		/**
+		 * @function : get the count of the received datagrams which have the magic of the packed
+		 * datagram but can't be split, eg : the datagram is truncated, they are dropped.
+		 */
+		inline std::size_t batch_drops() const { return this->batch_drops_.load(std::memory_order_relaxed); }
+
+	protected:
+		/**
+		 * @function : get the recv buffer size, the session recv the datagram into the buffer of the server
+		 */
+		inline std::size_t _batch_recv_size()
+		{
+			if constexpr (isSession)
+				return derive.buffer_ref_.pre_size();
+			else
+				return derive.buffer().pre_size();
+		}
+
+		/**
+		 * The message is queued into the pending datagram, the callback is called when the message is
+		 * queued, not when it's sent, so the success of the callback doesn't mean the message is sent.
+		 * The message which can't be packed into a datagram of the max size is failed with message_size.
+		 */
+		template<class Data, class Callback>
+		inline bool _batch_send(Data& data, Callback&& callback)
+		{
+			auto buffer = asio::buffer(data);
+
+			error_code ec;
+
+			if (buffer.size() + batch_header_size + 2 > this->batch_size_)
+			{
+				ec = asio::error::message_size;
+			}
+			else
+			{
+				// the message can't be packed into the pending datagram
+				if (this->batch_buffer_.size() + 2 + buffer.size() > this->batch_size_)
+					this->_batch_flush();
+
+				if (this->batch_buffer_.empty())
+					_write_le(this->batch_buffer_, batch_magic);
+
+				_write_le(this->batch_buffer_, static_cast<std::uint16_t>(buffer.size()));
+				this->batch_buffer_.append(static_cast<const char*>(buffer.data()), buffer.size());
+
+				if (this->batch_buffer_.size() >= this->batch_size_)
+					this->_batch_flush();
+				else if (!this->batch_timer_posted_)
+					this->_post_batch_timer();
+			}
+
+			set_last_error(ec);
+			callback(ec, ec ? 0 : buffer.size());
+
+#if defined(ASIO2_SEND_CORE_ASYNC)
+			derive.next_event();
+#endif
+
+			return (!bool(ec));
+		}
+
+		inline void _post_batch_timer()
+		{
+			this->batch_timer_posted_ = true;
+
+			this->batch_timer_.expires_after(this->batch_delay_);
+			this->batch_timer_.async_wait(asio::bind_executor(derive.io().strand(),
+				[this, self_ptr = derive.selfptr()](const error_code & ec)
+			{
+				detail::ignore::unused(self_ptr);
+
+				this->batch_timer_posted_ = false;
+
+				if (ec == asio::error::operation_aborted)
+					return;
+
+				this->_batch_flush();
+			}));
+		}
+
+		inline void _batch_flush()
+		{
+			if (this->batch_buffer_.empty())
+				return;
+
+			// the datagrams which are flushed by the timers of the io in one run are sent together
+			if constexpr (isSession)
+				udp_mmsg_sender::this_thread_sender().push(derive.stream(), &(derive.remote_endpoint_), this->batch_buffer_);
+			else
+				udp_mmsg_sender::this_thread_sender().push(derive.stream(), nullptr, this->batch_buffer_);
+
+			udp_mmsg_sender::this_thread_sender().post_flush(derive.io().strand());
+
+			this->batch_buffer_.clear();
+		}
+
+		inline void _batch_stop()
+		{
+			this->_batch_flush();
+
+			udp_mmsg_sender::this_thread_sender().flush();
+
+			try
+			{
+				this->batch_timer_.cancel();
+			}
+			catch (system_error &) {}
+		}
+
+		/**
+		 * @function : split the packed datagram into the messages
+		 * @return   : false if the datagram isn't a packed datagram, true if it's split or dropped
+		 * Function signature : void(std::string_view msg)
+		 */
+		template<class Function>
+		inline bool _batch_recv(std::string_view s, Function&& fn)
+		{
+			if (!this->is_batch() || s.size() < batch_header_size || _get_le(s.data()) != batch_magic)
+				return false;
+
+			std::size_t offset = batch_header_size;
+			while (offset + 2 <= s.size())
+				offset += 2 + _get_le(s.data() + offset);
+
+			// the packed datagram is broken or truncated, it's dropped instead of being passed as a
+			// normal datagram
+			if (offset != s.size())
+			{
+				this->batch_drops_.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+
+			offset = batch_header_size;
+			while (offset < s.size())
+			{
+				std::uint16_t size = _get_le(s.data() + offset);
+				offset += 2;
+				fn(std::string_view(s.data() + offset, size));
+				offset += size;
+			}
+
+			return true;
+		}
+
+		static inline void _write_le(std::string & s, std::uint16_t v)
+		{
+			s.push_back(static_cast<char>(v & 0xff));
+			s.push_back(static_cast<char>(v >> 8));
+		}
+
+		static inline std::uint16_t _get_le(const char * p)
+		{
+			return static_cast<std::uint16_t>(static_cast<std::uint8_t>(p[0]) |
+				(static_cast<std::uint16_t>(static_cast<std::uint8_t>(p[1])) << 8));
+		}
+
+	protected:
+		derived_t                 & derive;
+
+		/// the max delay of a message and the max size of the packed datagram, the batching is disabled if it's 0
+		std::chrono::microseconds   batch_delay_ = std::chrono::microseconds(0);
+		std::size_t                 batch_size_  = 0;
+
+		/// the pending datagram
+		std::string                 batch_buffer_;
+
+		asio::steady_timer          batch_timer_;
+
+		bool                        batch_timer_posted_ = false;
+
+		/// the count of the dropped packed datagrams
+		std::atomic<std::size_t>    batch_drops_{ 0 };
+	};
+}
+
+#endif // !__ASIO2_UDP_BATCH_COMPONENT_HPP__
@@ -0,0 +1,450 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_UDP_MCAST_COMPONENT_HPP__
+#define __ASIO2_UDP_MCAST_COMPONENT_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+#include <asio2/base/listener.hpp>
+
+#include <asio2/base/detail/util.hpp>
+
+#include <asio2/udp/detail/udp_mmsg.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * The sequenced publisher/subscriber of the udp cast, eg : market data fan-out over multicast.
+	 * The publisher packs the small messages of a group into the datagrams of mtu size, the datagram
+	 * is made up of :
+	 * | magic (2) | count (2) | stream (4) | seq (8) | timestamp (8) | len (2) msg | len (2) msg | ...
+	 * all the integers are little endian, the stream is a random id of the group of the publisher,
+	 * the seq is the sequence number of the first message, the timestamp is the nanoseconds of the
+	 * system clock when the datagram is sent.
+	 * The subscriber delivers the messages of each stream in sequence, the lost messages are
+	 * reported by the gap notification, and the late messages are dropped.
+	 */
+	template<class derived_t>
+	class udp_mcast_cp
+	{
+	public:
+		/// the size of the datagram header
+		static constexpr std::size_t mcast_header_size = 24;
+
+		static constexpr std::uint16_t mcast_magic = 0xA2C5;
+
+		/**
+		 * The counters of a stream received by the subscriber
+		 */
+		struct mcast_stream_stats
+		{
+			asio::ip::udp::endpoint publisher;
+			std::uint32_t           stream      = 0;
+			std::uint64_t           datagrams   = 0;
+			std::uint64_t           messages    = 0;
+			/// the count of the lost messages
+			std::uint64_t           lost        = 0;
+			/// the count of the gaps
+			std::uint64_t           gaps        = 0;
+			/// the count of the messages which are arrived after the later messages, they are dropped
+			std::uint64_t           late        = 0;
+			/// the latency in nanoseconds, it's meaningful only when the clocks of the hosts are synchronized
+			std::int64_t            latency_min = 0;
+			std::int64_t            latency_max = 0;
+			std::int64_t            latency_avg = 0;
+		};
+
+	public:
+		/**
+		 * @constructor
+		 */
+		udp_mcast_cp() : derive(static_cast<derived_t&>(*this)) {}
+
+		/**
+		 * @destructor
+		 */
+		~udp_mcast_cp() = default;
+
+	public:
+		/**
+		 * @function : set the max size of the datagram of the publisher, it should be set before start,
+		 * and it shouldn't be greater than the recv buffer size of the subscribers, eg : 1472 for the
+		 * ethernet when the subscribers are constructed with the init_buffer_size of 1472 at least.
+		 */
+		inline derived_t & mcast_mtu(std::size_t size)
+		{
+			this->mcast_mtu_ = (std::min<std::size_t>)((std::max<std::size_t>)(size,
+				mcast_header_size + 2 + 1), udp_gso_max_size);
+			return (this->derive);
+		}
+
+		/**
+		 * @function : get the max size of the datagram of the publisher
+		 */
+		inline std::size_t mcast_mtu() const
+		{
+			return this->mcast_mtu_;
+		}
+
+		/**
+		 * @function : publish a message to the group, the messages which are published in one run of
+		 * the io are packed into the datagrams of mtu size. This function can be called in any thread.
+		 * @return   : false if the cast is not started or the message is larger than the mtu
+		 */
+		inline bool publish(const asio::ip::udp::endpoint & group, std::string_view msg)
+		{
+			if (!derive.is_started())
+			{
+				set_last_error(asio::error::not_connected);
+				return false;
+			}
+
+			if (msg.size() + mcast_header_size + 2 > this->mcast_mtu_)
+			{
+				set_last_error(asio::error::message_size);
+				return false;
+			}
+
+			if (derive.io().strand().running_in_this_thread())
+			{
+				this->_mcast_publish(group, msg);
+				return true;
+			}
+
+			asio::post(derive.io().strand(), [this, group, msg = std::string(msg)]()
+			{
+				if (derive.is_started())
+					this->_mcast_publish(group, msg);
+			});
+			return true;
+		}
+
+		/**
+		 * @function : bind the message listener of the subscriber, when it's bound, the datagrams of
+		 * the publisher are unpacked and are not passed to the recv listener.
+		 * @param    : fun - a user defined callback function
+		 * @param    : obj - a pointer or reference to a class object, this parameter can be none
+		 * Function signature : void(asio::ip::udp::endpoint& publisher, std::uint64_t seq, std::string_view msg)
+		 */
+		template<class F, class ...C>
+		inline derived_t & bind_mcast_recv(F&& fun, C&&... obj)
+		{
+			derive.listener().bind(event::mcast_recv,
+				observer_t<asio::ip::udp::endpoint&, std::uint64_t, std::string_view>(
+					std::forward<F>(fun), std::forward<C>(obj)...));
+			return (this->derive);
+		}
+
+		/**
+		 * @function : bind the gap listener of the subscriber, it's called when the messages
+		 * [first, first + count) of a stream are lost.
+		 * @param    : fun - a user defined callback function
+		 * @param    : obj - a pointer or reference to a class object, this parameter can be none
+		 * Function signature : void(asio::ip::udp::endpoint& publisher, std::uint64_t first, std::uint64_t count)
+		 */
+		template<class F, class ...C>
+		inline derived_t & bind_mcast_gap(F&& fun, C&&... obj)
+		{
+			derive.listener().bind(event::mcast_gap,
+				observer_t<asio::ip::udp::endpoint&, std::uint64_t, std::uint64_t>(
+					std::forward<F>(fun), std::forward<C>(obj)...));
+			return (this->derive);
+		}
+
+		/**
+		 * @function : get the counters of all the streams received by the subscriber
+		 */
+		inline std::vector<mcast_stream_stats> mcast_stats()
+		{
+			std::lock_guard<std::mutex> guard(this->mcast_mutex_);
+
+			std::vector<mcast_stream_stats> stats;
+			stats.reserve(this->mcast_streams_.size());
+			for (auto & pair : this->mcast_streams_)
+			{
+				const sub_stream & s = pair.second;
+				stats.emplace_back(s.stats);
+				stats.back().latency_avg = s.latency_count ?
+					static_cast<std::int64_t>(s.latency_sum / static_cast<std::int64_t>(s.latency_count)) : 0;
+			}
+			return stats;
+		}
+
+	protected:
+		struct pub_group
+		{
+			asio::ip::udp::endpoint endpoint;
+			std::uint32_t           stream = 0;
+			std::uint64_t           seq    = 1;
+			std::uint16_t           count  = 0;
+			std::string             buffer;
+		};
+
+		struct sub_stream
+		{
+			mcast_stream_stats      stats;
+			/// the seq of the next message
+			std::uint64_t           next = 0;
+			std::int64_t            latency_sum   = 0;
+			std::uint64_t           latency_count = 0;
+		};
+
+		inline void _mcast_start()
+		{
+			std::lock_guard<std::mutex> guard(this->mcast_mutex_);
+			this->mcast_streams_.clear();
+		}
+
+		inline void _mcast_stop()
+		{
+			// send the packed messages before the socket is closed
+			this->_mcast_flush();
+
+			this->mcast_groups_.clear();
+		}
+
+		inline void _mcast_publish(const asio::ip::udp::endpoint & group, std::string_view msg)
+		{
+			pub_group & g = this->_mcast_group(group);
+
+			if (g.buffer.size() + 2 + msg.size() > this->mcast_mtu_ ||
+				g.count == (std::numeric_limits<std::uint16_t>::max)())
+			{
+				this->_mcast_send(g);
+				udp_mmsg_sender::this_thread_sender().post_flush(derive.io().strand());
+			}
+
+			_write_le(g.buffer, static_cast<std::uint16_t>(msg.size()));
+			g.buffer.append(msg.data(), msg.size());
+			++(g.count);
+
+			// send the packed messages after the current run of the strand, so the messages which
+			// are published in this run are packed together.
+			if (!this->mcast_flush_posted_)
+			{
+				this->mcast_flush_posted_ = true;
+				asio::post(derive.io().strand(), [this]()
+				{
+					this->mcast_flush_posted_ = false;
+					if (derive.is_started())
+						this->_mcast_flush();
+				});
+			}
+		}
+
+		inline pub_group & _mcast_group(const asio::ip::udp::endpoint & group)
+		{
+			// there are few groups usually, so the groups are searched linearly
+			if (this->mcast_last_ < this->mcast_groups_.size() &&
+				this->mcast_groups_[this->mcast_last_].endpoint == group)
+				return this->mcast_groups_[this->mcast_last_];
+
+			for (std::size_t i = 0; i < this->mcast_groups_.size(); ++i)
+			{
+				if (this->mcast_groups_[i].endpoint == group)
+				{
+					this->mcast_last_ = i;
+					return this->mcast_groups_[i];
+				}
+			}
+
+			std::random_device rd;
+
+			pub_group & g = this->mcast_groups_.emplace_back();
+			g.endpoint = group;
+			g.stream   = static_cast<std::uint32_t>(rd());
+			g.buffer.reserve(this->mcast_mtu_);
+			g.buffer.resize(mcast_header_size);
+
+			this->mcast_last_ = this->mcast_groups_.size() - 1;
+			return g;
+		}
+
+		inline void _mcast_send(pub_group & g)
+		{
+			if (g.count == 0)
+				return;
+
+			std::uint64_t now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count());
+
+			char * p = g.buffer.data();
+			_put_le(p +  0, mcast_magic);
+			_put_le(p +  2, g.count);
+			_put_le(p +  4, g.stream);
+			_put_le(p +  8, g.seq);
+			_put_le(p + 16, now);
+
+			udp_mmsg_sender::this_thread_sender().push(derive.stream(), &(g.endpoint), g.buffer);
+
+			g.seq += g.count;
+			g.count = 0;
+			g.buffer.resize(mcast_header_size);
+		}
+
+		inline void _mcast_flush()
+		{
+			for (pub_group & g : this->mcast_groups_)
+				this->_mcast_send(g);
+
+			udp_mmsg_sender::this_thread_sender().flush();
+		}
+
+		/**
+		 * @return : true if the datagram is consumed by the subscriber
+		 */
+		inline bool _mcast_handle_recv(asio::ip::udp::endpoint & publisher, std::string_view s)
+		{
+			if (!derive.listener().find(event::mcast_recv))
+				return false;
+
+			if (s.size() < mcast_header_size || _get_le<std::uint16_t>(s.data()) != mcast_magic)
+				return false;
+
+			std::uint16_t count  = _get_le<std::uint16_t>(s.data() + 2);
+			std::uint32_t stream = _get_le<std::uint32_t>(s.data() + 4);
+			std::uint64_t seq    = _get_le<std::uint64_t>(s.data() + 8);
+			std::int64_t  stamp  = static_cast<std::int64_t>(_get_le<std::uint64_t>(s.data() + 16));
+
+			// check the messages before any of them is delivered
+			std::size_t offset = mcast_header_size;
+			for (std::uint16_t i = 0; i < count; ++i)
+			{
+				if (offset + 2 > s.size())
+					return true;
+				offset += 2 + _get_le<std::uint16_t>(s.data() + offset);
+			}
+			if (offset != s.size())
+				return true;
+
+			std::int64_t latency = static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count()) - stamp;
+
+			std::uint64_t first = seq, lost = 0, skip = 0;
+			{
+				std::lock_guard<std::mutex> guard(this->mcast_mutex_);
+
+				sub_stream & ss = this->mcast_streams_[std::make_pair(publisher, stream)];
+				mcast_stream_stats & st = ss.stats;
+
+				if (st.datagrams == 0)
+				{
+					st.publisher   = publisher;
+					st.stream      = stream;
+					st.latency_min = latency;
+					st.latency_max = latency;
+					ss.next        = seq;
+				}
+
+				++(st.datagrams);
+
+				st.latency_min = (std::min)(st.latency_min, latency);
+				st.latency_max = (std::max)(st.latency_max, latency);
+				ss.latency_sum += latency;
+				++(ss.latency_count);
+
+				if (seq > ss.next)
+				{
+					first = ss.next;
+					lost  = seq - ss.next;
+					st.lost += lost;
+					++(st.gaps);
+				}
+				else if (seq < ss.next)
+				{
+					skip = (std::min<std::uint64_t>)(ss.next - seq, count);
+					st.late += skip;
+				}
+
+				st.messages += count - skip;
+				ss.next = (std::max)(ss.next, seq + count);
+			}
+
+			if (lost)
+				derive.listener().notify(event::mcast_gap, publisher, std::uint64_t(first), std::uint64_t(lost));
+
+			offset = mcast_header_size;
+			for (std::uint16_t i = 0; i < count; ++i)
+			{
+				std::uint16_t size = _get_le<std::uint16_t>(s.data() + offset);
+				offset += 2;
+				if (i >= skip)
+					derive.listener().notify(event::mcast_recv, publisher, std::uint64_t(seq + i),
+						std::string_view(s.data() + offset, size));
+				offset += size;
+			}
+
+			return true;
+		}
+
+		template<class T>
+		static inline void _put_le(char * p, T v)
+		{
+			for (std::size_t i = 0; i < sizeof(T); ++i)
+				p[i] = static_cast<char>(static_cast<std::uint8_t>(v >> (8 * i)));
+		}
+
+		template<class T>
+		static inline void _write_le(std::string & s, T v)
+		{
+			char b[sizeof(T)];
+			_put_le(b, v);
+			s.append(b, sizeof(T));
+		}
+
+		template<class T>
+		static inline T _get_le(const char * p)
+		{
+			T v = 0;
+			for (std::size_t i = 0; i < sizeof(T); ++i)
+				v |= static_cast<T>(static_cast<T>(static_cast<std::uint8_t>(p[i])) << (8 * i));
+			return v;
+		}
+
+	protected:
+		derived_t                                & derive;
+
+		/// the max size of the datagram of the publisher, it's equal to the recv buffer size of the
+		/// default udp cast, so the default subscriber can receive the whole datagram.
+		std::size_t                                mcast_mtu_ = udp_frame_size;
+
+		/// the groups of the publisher, they are used in the strand of the io only
+		std::vector<pub_group>                     mcast_groups_;
+
+		std::size_t                                mcast_last_ = 0;
+
+		bool                                       mcast_flush_posted_ = false;
+
+		/// the streams of the subscriber, the key is the publisher and the stream id
+		std::map<std::pair<asio::ip::udp::endpoint, std::uint32_t>, sub_stream> mcast_streams_;
+
+		/// the streams are updated in the strand of the io, and are read by the mcast_stats in any thread
+		std::mutex                                 mcast_mutex_;
+	};
+}
+
+#endif // !__ASIO2_UDP_MCAST_COMPONENT_HPP__
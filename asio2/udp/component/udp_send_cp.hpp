@@ -16,6 +16,7 @@
 #endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
 
 #include <cstdint>
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <string>
@@ -24,6 +25,10 @@
 #include <tuple>
 #include <utility>
 #include <string_view>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <asio2/base/selector.hpp>
 #include <asio2/base/iopool.hpp>
@@ -54,6 +59,30 @@ namespace asio2::detail
 		 */
 		~udp_send_cp() = default;
 
+	public:
+		/**
+		 * @function : set the time to live of the resolved endpoints of the send(host, port, data)
+		 * functions, the endpoints of a (host, port) are resolved once in the ttl, the numeric
+		 * address is never resolved. zero means don't cache the resolved endpoints.
+		 */
+		template<class Rep, class Period>
+		inline derived_t & resolve_cache_ttl(std::chrono::duration<Rep, Period> ttl)
+		{
+			std::unique_lock<std::shared_mutex> guard(this->resolve_mutex_);
+			this->resolve_ttl_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(ttl);
+			this->resolve_cache_.clear();
+			return (this->derive);
+		}
+
+		/**
+		 * @function : get the time to live of the resolved endpoints
+		 */
+		inline std::chrono::steady_clock::duration resolve_cache_ttl()
+		{
+			std::shared_lock<std::shared_mutex> guard(this->resolve_mutex_);
+			return this->resolve_ttl_;
+		}
+
 	public:
 		/**
 		 * @function : Asynchronous send data,supporting multi data formats,see asio::buffer(...) in /asio/buffer.hpp
@@ -668,6 +697,8 @@ namespace asio2::detail
 		}
 
 	protected:
+		using endpoints_ptr = std::shared_ptr<const std::vector<asio::ip::udp::endpoint>>;
+
 		template<typename String, typename StrOrInt, typename Data, typename Callback>
 		inline bool _do_resolve(String&& host, StrOrInt&& port, Data&& data, Callback&& callback)
 		{
@@ -675,17 +706,43 @@ namespace asio2::detail
 			using endpoints_type = typename resolver_type::results_type;
 			//using endpoints_iterator = typename endpoints_type::iterator;
 
+			std::string h = to_string(std::forward<String>(host));
+			std::string p = to_string(std::forward<StrOrInt>(port));
+
+			// the numeric address and port are used directly, there is nothing to resolve.
+			unsigned short port_num = 0;
+			if (_parse_port(p, port_num))
+			{
+				error_code ec;
+				asio::ip::address addr = asio::ip::make_address(h, ec);
+				if (!ec)
+				{
+					this->derive.push_event([this, endpoint = asio::ip::udp::endpoint(addr, port_num),
+						data = std::forward<Data>(data), callback = std::forward<Callback>(callback)]() mutable
+					{
+						return this->derive._do_send(endpoint, data, std::move(callback));
+					});
+					return true;
+				}
+			}
+
+			std::string key = h + '\0' + p;
+
+			if (endpoints_ptr endpoints = this->_find_resolved(key); endpoints)
+			{
+				this->_send_resolved(*endpoints, std::forward<Data>(data), std::forward<Callback>(callback));
+				return true;
+			}
+
 			std::unique_ptr<resolver_type> resolver_ptr = std::make_unique<resolver_type>(
 				this->derive.io().context());
 
 			// Before async_resolve execution is complete, we must hold the resolver object.
 			// so we captured the resolver_ptr into the lambda callback function.
 			resolver_type * resolver_pointer = resolver_ptr.get();
-			resolver_pointer->async_resolve(
-				to_string(std::forward<String>(host)),
-				to_string(std::forward<StrOrInt>(port)),
+			resolver_pointer->async_resolve(h, p,
 				asio::bind_executor(this->derive.io().strand(),
-					[this, p = this->derive.selfptr(), resolver_ptr = std::move(resolver_ptr),
+					[this, p = this->derive.selfptr(), resolver_ptr = std::move(resolver_ptr), key = std::move(key),
 					data = std::forward<Data>(data), callback = std::forward<Callback>(callback)]
 			(const error_code& ec, const endpoints_type& endpoints) mutable
 			{
@@ -697,21 +754,109 @@ namespace asio2::detail
 				}
 				else
 				{
-					decltype(endpoints.size()) i = 1;
-					for (auto iter = endpoints.begin(); iter != endpoints.end(); ++iter, ++i)
-					{
-						this->derive.push_event([this, endpoint = iter->endpoint(),
-							data = (endpoints.size() == i ? std::move(data) : data),
-							callback = (endpoints.size() == i ? std::move(callback) : callback)
-						]() mutable
-						{
-							return this->derive._do_send(endpoint, data, std::move(callback));
-						});
-					}
+					std::shared_ptr<std::vector<asio::ip::udp::endpoint>> resolved =
+						std::make_shared<std::vector<asio::ip::udp::endpoint>>();
+					resolved->reserve(endpoints.size());
+					for (auto iter = endpoints.begin(); iter != endpoints.end(); ++iter)
+						resolved->emplace_back(iter->endpoint());
+
+					this->_send_resolved(*resolved, std::move(data), std::move(callback));
+
+					this->_save_resolved(std::move(key), std::move(resolved));
 				}
 			}));
 			return true;
 		}
+
+		template<typename Data, typename Callback>
+		inline void _send_resolved(const std::vector<asio::ip::udp::endpoint> & endpoints,
+			Data&& data, Callback&& callback)
+		{
+			std::size_t i = 1;
+			for (auto iter = endpoints.begin(); iter != endpoints.end(); ++iter, ++i)
+			{
+				this->derive.push_event([this, endpoint = *iter,
+					data = (endpoints.size() == i ? std::move(data) : data),
+					callback = (endpoints.size() == i ? std::move(callback) : callback)
+				]() mutable
+				{
+					return this->derive._do_send(endpoint, data, std::move(callback));
+				});
+			}
+		}
+
+		static inline bool _parse_port(const std::string & s, unsigned short & port)
+		{
+			if (s.empty() || s.size() > 5)
+				return false;
+
+			unsigned int n = 0;
+			for (char c : s)
+			{
+				if (c < '0' || c > '9')
+					return false;
+				n = n * 10 + static_cast<unsigned int>(c - '0');
+			}
+
+			if (n > 65535)
+				return false;
+
+			port = static_cast<unsigned short>(n);
+			return true;
+		}
+
+		inline endpoints_ptr _find_resolved(const std::string & key)
+		{
+			std::shared_lock<std::shared_mutex> guard(this->resolve_mutex_);
+			auto iter = this->resolve_cache_.find(key);
+			if (iter == this->resolve_cache_.end() || iter->second.expiry < std::chrono::steady_clock::now())
+				return endpoints_ptr();
+			return iter->second.endpoints;
+		}
+
+		inline void _save_resolved(std::string key, endpoints_ptr endpoints)
+		{
+			std::unique_lock<std::shared_mutex> guard(this->resolve_mutex_);
+
+			if (this->resolve_ttl_ <= std::chrono::steady_clock::duration::zero())
+				return;
+
+			auto now = std::chrono::steady_clock::now();
+
+			// the hosts are few usually, the expired entries are removed when the cache is full.
+			if (this->resolve_cache_.size() >= resolve_cache_max_size)
+			{
+				for (auto iter = this->resolve_cache_.begin(); iter != this->resolve_cache_.end();)
+				{
+					if (iter->second.expiry < now)
+						iter = this->resolve_cache_.erase(iter);
+					else
+						++iter;
+				}
+
+				if (this->resolve_cache_.size() >= resolve_cache_max_size)
+					this->resolve_cache_.clear();
+			}
+
+			this->resolve_cache_[std::move(key)] = resolve_entry{ std::move(endpoints), now + this->resolve_ttl_ };
+		}
+
+	protected:
+		struct resolve_entry
+		{
+			endpoints_ptr                          endpoints;
+			std::chrono::steady_clock::time_point  expiry;
+		};
+
+		/// the max count of the cached (host, port)
+		static constexpr std::size_t resolve_cache_max_size = 1024;
+
+		/// the resolved endpoints of the (host, port), the key is "host\0port"
+		std::unordered_map<std::string, resolve_entry> resolve_cache_;
+
+		std::shared_mutex                              resolve_mutex_;
+
+		std::chrono::steady_clock::duration            resolve_ttl_ = std::chrono::seconds(60);
 	};
 }
 
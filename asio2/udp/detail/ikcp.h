@@ -287,7 +287,7 @@ struct IKCPCB
 	IUINT32 ts_recent, ts_lastack, ssthresh;
 	IINT32 rx_rttval, rx_srtt, rx_rto, rx_minrto;
 	IUINT32 snd_wnd, rcv_wnd, rmt_wnd, cwnd, probe;
-	IUINT32 current, interval, ts_flush, xmit;
+	IUINT32 current, interval, ts_flush, xmit, fast_xmit;
 	IUINT32 nrcv_buf, nsnd_buf;
 	IUINT32 nrcv_que, nsnd_que;
 	IUINT32 nodelay, updated;
@@ -506,8 +506,9 @@ static inline long _itimediff(IUINT32 later, IUINT32 earlier)
 //---------------------------------------------------------------------
 typedef struct IKCPSEG IKCPSEG;
 
-static void* (*ikcp_malloc_hook)(size_t) = NULL;
-static void (*ikcp_free_hook)(void *) = NULL;
+// the hooks are inline variables, so all the translation units share the same allocator
+inline void* (*ikcp_malloc_hook)(size_t) = NULL;
+inline void (*ikcp_free_hook)(void *) = NULL;
 
 // internal malloc
 template<typename = void>
@@ -1004,6 +1005,7 @@ ikcpcb* ikcp_create(IUINT32 conv, void *user)
 	kcp->fastresend = 0;
 	kcp->nocwnd = 0;
 	kcp->xmit = 0;
+	kcp->fast_xmit = 0;
 	kcp->dead_link = IKCP_DEADLINK;
 	kcp->output = NULL;
 	kcp->writelog = NULL;
@@ -1208,6 +1210,7 @@ void ikcp_flush(ikcpcb *kcp)
 		else if (segment->fastack >= resent) {
 			needsend = 1;
 			segment->xmit++;
+			kcp->fast_xmit++;
 			segment->fastack = 0;
 			segment->resendts = current + segment->rto;
 			change++;
@@ -0,0 +1,205 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_KCP_COOKIE_HPP__
+#define __ASIO2_KCP_COOKIE_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string_view>
+
+#include <asio2/base/selector.hpp>
+
+#include <asio2/udp/detail/kcp_util.hpp>
+
+namespace asio2::detail::kcp
+{
+	/**
+	 * The stateless handshake cookie of the kcp server, the server replies the syn with the cookie
+	 * directly, and the session is created only when the client echoes a valid cookie, so the
+	 * garbage datagrams with the spoofed source address never allocate the sessions.
+	 * The cookie is used as the conv of the kcp, it's made up of :
+	 * | mac (22 bits) | fec data shards (5 bits) | fec parity shards (5 bits) |
+	 * the mac is the keyed hash (siphash-2-4) of the endpoint, the fec shards and the time bucket,
+	 * the key is random for each server, and the cookie is valid for two time buckets.
+	 */
+	class kcp_cookie
+	{
+	public:
+		/// the lifetime of a time bucket
+		static constexpr std::chrono::seconds bucket_duration = std::chrono::seconds(30);
+
+		kcp_cookie()
+		{
+			std::random_device rd;
+			this->k0_ = (std::uint64_t(rd()) << 32) | std::uint64_t(rd());
+			this->k1_ = (std::uint64_t(rd()) << 32) | std::uint64_t(rd());
+		}
+
+		/**
+		 * @function : make the cookie for the endpoint
+		 */
+		inline std::uint32_t make(const asio::ip::udp::endpoint & endpoint,
+			std::uint8_t fec_data, std::uint8_t fec_parity) const
+		{
+			std::uint32_t fec = ((std::uint32_t(fec_data) & 0x1f) << 5) | (std::uint32_t(fec_parity) & 0x1f);
+			return (this->_mac(endpoint, fec, kcp_cookie::_bucket()) << 10) | fec;
+		}
+
+		/**
+		 * @function : check whether the cookie is made for the endpoint by this server recently
+		 */
+		inline bool verify(const asio::ip::udp::endpoint & endpoint, std::uint32_t cookie) const
+		{
+			std::uint32_t fec    = cookie & 0x3ff;
+			std::uint32_t mac    = cookie >> 10;
+			std::uint64_t bucket = kcp_cookie::_bucket();
+			return (mac == this->_mac(endpoint, fec, bucket) || mac == this->_mac(endpoint, fec, bucket - 1));
+		}
+
+		static inline std::uint8_t fec_data  (std::uint32_t cookie) { return std::uint8_t((cookie >> 5) & 0x1f); }
+		static inline std::uint8_t fec_parity(std::uint32_t cookie) { return std::uint8_t((cookie     ) & 0x1f); }
+
+		/**
+		 * @function : get the cookie which is echoed by the client.
+		 * the ack of the handshake carries the cookie in the th_ack, and if the ack is lost, the
+		 * first kcp datagram carries the cookie in the conv.
+		 * @return   : false if the datagram can't carry a cookie
+		 */
+		static inline bool parse(std::string_view s, std::uint32_t & cookie)
+		{
+			const std::uint8_t * p = reinterpret_cast<const std::uint8_t*>(s.data());
+
+			if (s.size() == sizeof(kcphdr))
+			{
+				kcphdr * hdr = (kcphdr*)(s.data());
+				if (!is_kcphdr_ack(s, hdr->th_ack - 1))
+					return false;
+				cookie = hdr->th_ack - 1;
+				return true;
+			}
+
+			if (s.size() < IKCP_OVERHEAD)
+				return false;
+
+			// the fec data shard : seqid(4) type(2) size(2) kcp segment
+			if (p[4] == 0xf1 && p[5] == 0 && s.size() >= IKCP_OVERHEAD + 8)
+			{
+				cookie = kcp_cookie::_read_u32(p + 8);
+				return (kcp_cookie::fec_data(cookie) != 0 && kcp_cookie::is_kcp_cmd(p[12]));
+			}
+
+			cookie = kcp_cookie::_read_u32(p);
+			return (kcp_cookie::fec_data(cookie) == 0 && kcp_cookie::is_kcp_cmd(p[4]));
+		}
+
+		static inline bool is_kcp_cmd(std::uint8_t cmd)
+		{
+			return (cmd >= IKCP_CMD_PUSH && cmd <= IKCP_CMD_WINS);
+		}
+
+	protected:
+		static inline std::uint64_t _bucket()
+		{
+			return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch() / bucket_duration);
+		}
+
+		static inline std::uint32_t _read_u32(const std::uint8_t * p)
+		{
+			return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+				(static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+		}
+
+		inline std::uint32_t _mac(const asio::ip::udp::endpoint & endpoint, std::uint32_t fec, std::uint64_t bucket) const
+		{
+			// address(16) port(2) fec(2) bucket(8)
+			std::uint8_t msg[28] = { 0 };
+
+			if (endpoint.address().is_v4())
+			{
+				auto bytes = endpoint.address().to_v4().to_bytes();
+				std::memcpy(msg, bytes.data(), bytes.size());
+			}
+			else
+			{
+				auto bytes = endpoint.address().to_v6().to_bytes();
+				std::memcpy(msg, bytes.data(), bytes.size());
+			}
+
+			std::uint16_t port = endpoint.port();
+			msg[16] = static_cast<std::uint8_t>(port);
+			msg[17] = static_cast<std::uint8_t>(port >> 8);
+			msg[18] = static_cast<std::uint8_t>(fec);
+			msg[19] = static_cast<std::uint8_t>(fec >> 8);
+			for (int i = 0; i < 8; ++i)
+				msg[20 + i] = static_cast<std::uint8_t>(bucket >> (8 * i));
+
+			return static_cast<std::uint32_t>(this->_siphash(msg, sizeof(msg)) & 0x3fffff);
+		}
+
+		static inline std::uint64_t _rotl(std::uint64_t x, int b)
+		{
+			return (x << b) | (x >> (64 - b));
+		}
+
+		/// siphash-2-4
+		inline std::uint64_t _siphash(const std::uint8_t * data, std::size_t size) const
+		{
+			std::uint64_t v0 = 0x736f6d6570736575ULL ^ this->k0_;
+			std::uint64_t v1 = 0x646f72616e646f6dULL ^ this->k1_;
+			std::uint64_t v2 = 0x6c7967656e657261ULL ^ this->k0_;
+			std::uint64_t v3 = 0x7465646279746573ULL ^ this->k1_;
+
+			auto round = [&]()
+			{
+				v0 += v1; v1 = _rotl(v1, 13); v1 ^= v0; v0 = _rotl(v0, 32);
+				v2 += v3; v3 = _rotl(v3, 16); v3 ^= v2;
+				v0 += v3; v3 = _rotl(v3, 21); v3 ^= v0;
+				v2 += v1; v1 = _rotl(v1, 17); v1 ^= v2; v2 = _rotl(v2, 32);
+			};
+
+			std::size_t blocks = size / 8;
+			for (std::size_t i = 0; i < blocks; ++i)
+			{
+				std::uint64_t m = 0;
+				for (int k = 0; k < 8; ++k)
+					m |= std::uint64_t(data[i * 8 + k]) << (8 * k);
+				v3 ^= m;
+				round(); round();
+				v0 ^= m;
+			}
+
+			std::uint64_t b = std::uint64_t(size) << 56;
+			for (std::size_t k = 0; k < size % 8; ++k)
+				b |= std::uint64_t(data[blocks * 8 + k]) << (8 * k);
+
+			v3 ^= b;
+			round(); round();
+			v0 ^= b;
+
+			v2 ^= 0xff;
+			round(); round(); round(); round();
+
+			return v0 ^ v1 ^ v2 ^ v3;
+		}
+
+	protected:
+		std::uint64_t k0_ = 0;
+		std::uint64_t k1_ = 0;
+	};
+}
+
+#endif // !__ASIO2_KCP_COOKIE_HPP__
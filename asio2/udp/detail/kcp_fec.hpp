@@ -0,0 +1,644 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ *
+ * The forward error correction of the kcp datagrams, the format is compatible with kcp-go :
+ * | seqid (4 bytes) | flag (2 bytes) | size (2 bytes, data shard only) | payload |
+ * The shards of a group are the consecutive seqids, data shards first, parity shards follow.
+ * A partial group is closed by its parity shards, the seqids of its unsent data shards are skipped,
+ * and the count of its sent data shards is carried by the high byte of the flag of the parity.
+ * The parity is computed over the "size + payload" of the data shards which are padded with
+ * zero to the max length of the group.
+ */
+
+#ifndef __ASIO2_KCP_FEC_HPP__
+#define __ASIO2_KCP_FEC_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <vector>
+#include <string_view>
+
+namespace asio2::detail::kcp
+{
+	/// the max count of the data shards or the parity shards, it's limited by the bits of kcphdr
+	static constexpr std::size_t fec_max_shards = 31;
+
+	/// the bytes of the fec header : seqid + flag
+	static constexpr std::size_t fec_header_size = 6;
+
+	/// the bytes of the size field of the data shard
+	static constexpr std::size_t fec_size_size = 2;
+
+	/// the total overhead bytes of a data shard
+	static constexpr std::size_t fec_overhead = fec_header_size + fec_size_size;
+
+	static constexpr std::uint16_t fec_type_data   = 0xf1;
+	static constexpr std::uint16_t fec_type_parity = 0xf2;
+
+	/**
+	 * The arithmetic of GF(2^8), the primitive polynomial is 0x11d.
+	 */
+	class galois
+	{
+	public:
+		static inline const galois & instance()
+		{
+			static galois g;
+			return g;
+		}
+
+		inline std::uint8_t mul(std::uint8_t a, std::uint8_t b) const
+		{
+			return this->mul_[a][b];
+		}
+
+		inline std::uint8_t div(std::uint8_t a, std::uint8_t b) const
+		{
+			if (a == 0)
+				return 0;
+			return this->exp_[this->log_[a] + 255 - this->log_[b]];
+		}
+
+		inline std::uint8_t exp(std::uint8_t a, std::size_t n) const
+		{
+			if (n == 0)
+				return 1;
+			if (a == 0)
+				return 0;
+			return this->exp_[(this->log_[a] * n) % 255];
+		}
+
+		/**
+		 * @function : dst ^= c * src
+		 */
+		inline void mul_add(std::uint8_t c, const std::uint8_t * src, std::uint8_t * dst, std::size_t size) const
+		{
+			if (c == 0)
+				return;
+			const std::uint8_t * row = this->mul_[c];
+			for (std::size_t i = 0; i < size; ++i)
+				dst[i] ^= row[src[i]];
+		}
+
+	protected:
+		galois()
+		{
+			unsigned x = 1;
+			for (unsigned i = 0; i < 255; ++i)
+			{
+				this->exp_[i] = static_cast<std::uint8_t>(x);
+				this->log_[x] = static_cast<std::uint8_t>(i);
+				x <<= 1;
+				if (x & 0x100)
+					x ^= 0x11d;
+			}
+			for (unsigned i = 255; i < sizeof(this->exp_); ++i)
+				this->exp_[i] = this->exp_[i - 255];
+			this->log_[0] = 0;
+
+			for (unsigned a = 0; a < 256; ++a)
+				for (unsigned b = 0; b < 256; ++b)
+					this->mul_[a][b] = (a == 0 || b == 0) ? std::uint8_t(0) :
+						this->exp_[this->log_[a] + this->log_[b]];
+		}
+
+	protected:
+		std::uint8_t exp_[512] = {};
+		std::uint8_t log_[256] = {};
+		std::uint8_t mul_[256][256] = {};
+	};
+
+	/**
+	 * The systematic Reed-Solomon codec, the encoding matrix is made from the vandermonde matrix
+	 * whose top square is changed to the identity matrix, so any data_shards rows of it can be
+	 * inverted, and the data can be recovered from any data_shards shards of the group.
+	 */
+	class reed_solomon
+	{
+	public:
+		reed_solomon(std::size_t data_shards, std::size_t parity_shards)
+			: data_shards_(data_shards), parity_shards_(parity_shards)
+			, matrix_((data_shards + parity_shards) * data_shards)
+		{
+			const galois & gf = galois::instance();
+
+			std::size_t total = data_shards + parity_shards;
+			std::size_t d = data_shards;
+
+			std::vector<std::uint8_t> vm(total * d);
+			for (std::size_t r = 0; r < total; ++r)
+				for (std::size_t c = 0; c < d; ++c)
+					vm[r * d + c] = gf.exp(static_cast<std::uint8_t>(r), c);
+
+			std::vector<std::uint8_t> top(vm.begin(), vm.begin() + d * d);
+			reed_solomon::_invert(top, d);
+
+			for (std::size_t r = 0; r < total; ++r)
+				for (std::size_t c = 0; c < d; ++c)
+				{
+					std::uint8_t v = 0;
+					for (std::size_t k = 0; k < d; ++k)
+						v ^= gf.mul(vm[r * d + k], top[k * d + c]);
+					this->matrix_[r * d + c] = v;
+				}
+		}
+
+		inline std::size_t data_shards  () const { return this->data_shards_;   }
+		inline std::size_t parity_shards() const { return this->parity_shards_; }
+
+		/**
+		 * @function : compute the parity shards, all the shards have the same size
+		 */
+		inline void encode(const std::uint8_t * const * data, std::uint8_t * const * parity, std::size_t size) const
+		{
+			const galois & gf = galois::instance();
+
+			std::size_t d = this->data_shards_;
+			for (std::size_t p = 0; p < this->parity_shards_; ++p)
+			{
+				std::memset(parity[p], 0, size);
+				const std::uint8_t * row = &(this->matrix_[(d + p) * d]);
+				for (std::size_t c = 0; c < d; ++c)
+					gf.mul_add(row[c], data[c], parity[p], size);
+			}
+		}
+
+		/**
+		 * @function : recover the missing data shards
+		 * @param    : shards - all the shards of the group, the missing shard is nullptr, the
+		 *             recovered data shard is written into the buffer of outputs[i]
+		 * @return   : false if the present shards are less than data_shards
+		 */
+		inline bool reconstruct(const std::uint8_t * const * shards, std::uint8_t * const * outputs, std::size_t size) const
+		{
+			const galois & gf = galois::instance();
+
+			std::size_t d = this->data_shards_;
+			std::size_t total = d + this->parity_shards_;
+
+			std::vector<std::uint8_t> sub(d * d);
+			std::vector<const std::uint8_t*> inputs;
+			inputs.reserve(d);
+
+			for (std::size_t i = 0; i < total && inputs.size() < d; ++i)
+			{
+				if (!shards[i])
+					continue;
+				std::memcpy(&sub[inputs.size() * d], &(this->matrix_[i * d]), d);
+				inputs.emplace_back(shards[i]);
+			}
+
+			if (inputs.size() < d)
+				return false;
+
+			if (!reed_solomon::_invert(sub, d))
+				return false;
+
+			for (std::size_t i = 0; i < d; ++i)
+			{
+				if (shards[i])
+					continue;
+				std::memset(outputs[i], 0, size);
+				for (std::size_t k = 0; k < d; ++k)
+					gf.mul_add(sub[i * d + k], inputs[k], outputs[i], size);
+			}
+
+			return true;
+		}
+
+	protected:
+		/// gauss-jordan elimination of the n x n matrix
+		static inline bool _invert(std::vector<std::uint8_t> & m, std::size_t n)
+		{
+			const galois & gf = galois::instance();
+
+			std::vector<std::uint8_t> inv(n * n, 0);
+			for (std::size_t i = 0; i < n; ++i)
+				inv[i * n + i] = 1;
+
+			for (std::size_t c = 0; c < n; ++c)
+			{
+				std::size_t pivot = c;
+				while (pivot < n && m[pivot * n + c] == 0)
+					++pivot;
+				if (pivot == n)
+					return false;
+
+				if (pivot != c)
+				{
+					for (std::size_t k = 0; k < n; ++k)
+					{
+						std::swap(m  [pivot * n + k], m  [c * n + k]);
+						std::swap(inv[pivot * n + k], inv[c * n + k]);
+					}
+				}
+
+				std::uint8_t v = m[c * n + c];
+				if (v != 1)
+				{
+					for (std::size_t k = 0; k < n; ++k)
+					{
+						m  [c * n + k] = gf.div(m  [c * n + k], v);
+						inv[c * n + k] = gf.div(inv[c * n + k], v);
+					}
+				}
+
+				for (std::size_t r = 0; r < n; ++r)
+				{
+					if (r == c || m[r * n + c] == 0)
+						continue;
+					std::uint8_t f = m[r * n + c];
+					gf.mul_add(f, &m  [c * n], &m  [r * n], n);
+					gf.mul_add(f, &inv[c * n], &inv[r * n], n);
+				}
+			}
+
+			m.swap(inv);
+			return true;
+		}
+
+	protected:
+		std::size_t               data_shards_;
+		std::size_t               parity_shards_;
+
+		/// (data_shards + parity_shards) x data_shards
+		std::vector<std::uint8_t> matrix_;
+	};
+
+	inline void fec_write_u16(std::uint8_t * p, std::uint16_t v)
+	{
+		p[0] = static_cast<std::uint8_t>(v);
+		p[1] = static_cast<std::uint8_t>(v >> 8);
+	}
+
+	inline void fec_write_u32(std::uint8_t * p, std::uint32_t v)
+	{
+		p[0] = static_cast<std::uint8_t>(v);
+		p[1] = static_cast<std::uint8_t>(v >> 8);
+		p[2] = static_cast<std::uint8_t>(v >> 16);
+		p[3] = static_cast<std::uint8_t>(v >> 24);
+	}
+
+	inline std::uint16_t fec_read_u16(const std::uint8_t * p)
+	{
+		return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+	}
+
+	inline std::uint32_t fec_read_u32(const std::uint8_t * p)
+	{
+		return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+			(static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+	}
+
+	/**
+	 * The fec encoder and decoder of a kcp stream.
+	 */
+	class fec_codec
+	{
+	public:
+		/// the max count of the groups which are waiting for the recovery
+		static constexpr std::size_t max_groups = 64;
+
+		fec_codec(std::size_t data_shards, std::size_t parity_shards)
+			: rs_(data_shards, parity_shards)
+			, shard_count_(static_cast<std::uint32_t>(data_shards + parity_shards))
+			, paws_((std::numeric_limits<std::uint32_t>::max)() / shard_count_ * shard_count_)
+			, send_shards_(data_shards)
+			, parity_shards_(parity_shards)
+		{
+		}
+
+		inline std::size_t data_shards  () const { return this->rs_.data_shards();   }
+		inline std::size_t parity_shards() const { return this->rs_.parity_shards(); }
+
+		/**
+		 * @function : make the fec datagrams of the kcp datagram.
+		 * @param    : output - Function signature : void(std::string_view datagram)
+		 */
+		template<class Function>
+		inline void encode(const char * buf, std::size_t len, Function&& output)
+		{
+			std::size_t d = this->rs_.data_shards();
+
+			// data shard : header + size + payload
+			std::vector<std::uint8_t> & shard = this->send_shards_[this->send_count_];
+			shard.resize(fec_overhead + len);
+			fec_write_u32(shard.data(), this->_next_seqid());
+			fec_write_u16(shard.data() + 4, fec_type_data);
+			fec_write_u16(shard.data() + fec_header_size, static_cast<std::uint16_t>(fec_size_size + len));
+			std::memcpy(shard.data() + fec_overhead, buf, len);
+
+			output(std::string_view(reinterpret_cast<const char*>(shard.data()), shard.size()));
+
+			this->send_max_ = (std::max)(this->send_max_, fec_size_size + len);
+			this->send_idle_ = false;
+
+			if (++(this->send_count_) < d)
+				return;
+
+			// the group is full, make the parity shards
+			this->_encode_parity(output);
+		}
+
+		/**
+		 * @function : called by each update of the kcp, if a group is still partial since the last
+		 * call, its parity shards are sent at once, otherwise the last datagrams of a burst are not
+		 * protected until the following datagrams fill the group.
+		 * @param    : output - Function signature : void(std::string_view datagram)
+		 */
+		template<class Function>
+		inline void tick(Function&& output)
+		{
+			if (this->send_count_ == 0)
+				return;
+
+			if (!this->send_idle_)
+			{
+				this->send_idle_ = true;
+				return;
+			}
+
+			this->flush(output);
+		}
+
+		/**
+		 * @function : send the parity shards of the partial group, the data shards which are not
+		 * sent are treated as zero, and their seqids are skipped. the parity carries the count of the
+		 * sent data shards, so the receiver knows the zero shards and needn't wait for them.
+		 * @param    : output - Function signature : void(std::string_view datagram)
+		 */
+		template<class Function>
+		inline void flush(Function&& output)
+		{
+			if (this->send_count_ == 0)
+				return;
+
+			this->_encode_parity(output);
+		}
+
+		/**
+		 * @function : parse the fec datagram, the data shard is passed to the input immediately,
+		 * and the data shards which are recovered by the parity shards are passed to the input too.
+		 * @param    : input - Function signature : int(const char* data, std::size_t size)
+		 * @return   : the return value of the input for the datagram itself, -1 if it's invalid
+		 */
+		template<class Function>
+		inline int decode(std::string_view s, Function&& input)
+		{
+			if (s.size() < fec_header_size + fec_size_size)
+				return -1;
+
+			const std::uint8_t * p = reinterpret_cast<const std::uint8_t*>(s.data());
+
+			std::uint32_t seqid = fec_read_u32(p);
+			std::uint16_t type  = fec_read_u16(p + 4);
+
+			// the data shards count of a partial group
+			std::size_t sent = this->rs_.data_shards();
+			if ((type & 0xff) == fec_type_parity && (type >> 8) != 0)
+			{
+				sent = static_cast<std::size_t>(type >> 8);
+				type = fec_type_parity;
+				if (sent >= this->rs_.data_shards())
+					return -1;
+			}
+
+			int ret = 0;
+
+			if /**/ (type == fec_type_data)
+			{
+				std::uint16_t size = fec_read_u16(p + fec_header_size);
+				if (size < fec_size_size || size > s.size() - fec_header_size)
+					return -1;
+
+				ret = input(s.data() + fec_overhead, std::size_t(size - fec_size_size));
+			}
+			else if (type != fec_type_parity)
+			{
+				return -1;
+			}
+
+			this->_recover(seqid, type, sent, p + fec_header_size, s.size() - fec_header_size, input);
+
+			return ret;
+		}
+
+	protected:
+		struct group
+		{
+			std::uint32_t                          id = 0;
+			std::size_t                            count = 0;
+			std::size_t                            data_count = 0;
+			bool                                   done = false;
+			std::vector<std::vector<std::uint8_t>> shards;
+		};
+
+		inline std::uint32_t _next_seqid()
+		{
+			std::uint32_t seqid = this->send_seqid_;
+			this->send_seqid_ = (this->send_seqid_ + 1) % this->paws_;
+			return seqid;
+		}
+
+		template<class Function>
+		inline void _encode_parity(Function& output)
+		{
+			std::size_t d = this->rs_.data_shards();
+			std::size_t size = this->send_max_;
+
+			const std::uint8_t * data[fec_max_shards];
+			std::uint8_t * parity[fec_max_shards];
+
+			for (std::size_t i = 0; i < d; ++i)
+			{
+				std::vector<std::uint8_t> & s = this->send_shards_[i];
+				if (i < this->send_count_)
+					s.resize(fec_header_size + size, 0);
+				else
+					s.assign(fec_header_size + size, 0);
+				data[i] = s.data() + fec_header_size;
+			}
+			for (std::size_t i = 0; i < this->parity_shards_.size(); ++i)
+			{
+				std::vector<std::uint8_t> & s = this->parity_shards_[i];
+				s.resize(fec_header_size + size);
+				parity[i] = s.data() + fec_header_size;
+			}
+
+			this->rs_.encode(data, parity, size);
+
+			// the parity shards are always at the parity position of the group
+			this->send_seqid_ = (this->send_seqid_ + static_cast<std::uint32_t>(d - this->send_count_)) % this->paws_;
+
+			std::uint16_t flag = fec_type_parity;
+			if (this->send_count_ < d)
+				flag |= static_cast<std::uint16_t>(this->send_count_ << 8);
+
+			for (std::vector<std::uint8_t> & s : this->parity_shards_)
+			{
+				fec_write_u32(s.data(), this->_next_seqid());
+				fec_write_u16(s.data() + 4, flag);
+				output(std::string_view(reinterpret_cast<const char*>(s.data()), s.size()));
+			}
+
+			this->send_count_ = 0;
+			this->send_max_   = 0;
+			this->send_idle_  = false;
+		}
+
+		template<class Function>
+		inline void _recover(std::uint32_t seqid, std::uint16_t type, std::size_t sent,
+			const std::uint8_t * shard, std::size_t size, Function& input)
+		{
+			std::size_t d = this->rs_.data_shards();
+
+			std::uint32_t id    = seqid / this->shard_count_;
+			std::size_t   index = seqid % this->shard_count_;
+
+			// the parity shard must be at the parity position, and vice versa.
+			if ((type == fec_type_data) != (index < d))
+				return;
+
+			group * g = nullptr;
+			for (group & x : this->groups_)
+			{
+				if (x.id == id)
+				{
+					g = &x;
+					break;
+				}
+			}
+
+			if (!g)
+			{
+				if (this->groups_.size() >= max_groups)
+					this->groups_.pop_front();
+				g = &(this->groups_.emplace_back());
+				g->id = id;
+				g->shards.resize(this->shard_count_);
+			}
+
+			if (g->done || !g->shards[index].empty())
+				return;
+
+			g->shards[index].assign(shard, shard + size);
+			++(g->count);
+			if (index < d)
+				++(g->data_count);
+
+			// the unsent data shards of a partial group are zero, the parity has the max length.
+			for (std::size_t i = sent; i < d; ++i)
+			{
+				if (!g->shards[i].empty())
+					continue;
+				g->shards[i].assign(size, 0);
+				++(g->count);
+				++(g->data_count);
+			}
+
+			// all the data shards are arrived, needn't recovery.
+			if (g->data_count == d)
+			{
+				this->_finish(*g);
+				return;
+			}
+
+			if (g->count < d)
+				return;
+
+			// the parity shard has the max length of the group.
+			std::size_t max_size = 0;
+			for (std::size_t i = d; i < this->shard_count_; ++i)
+				if (!g->shards[i].empty())
+					max_size = (std::max)(max_size, g->shards[i].size());
+
+			const std::uint8_t * shards[2 * fec_max_shards];
+			std::uint8_t * outputs[fec_max_shards];
+
+			for (std::size_t i = 0; i < this->shard_count_; ++i)
+			{
+				std::vector<std::uint8_t> & x = g->shards[i];
+				if (x.empty())
+				{
+					shards[i] = nullptr;
+					if (i < d)
+					{
+						x.resize(max_size);
+						outputs[i] = x.data();
+					}
+				}
+				else
+				{
+					if ((i >= d && x.size() != max_size) || x.size() > max_size)
+					{
+						this->_finish(*g);
+						return;
+					}
+					x.resize(max_size, 0);
+					shards[i] = x.data();
+				}
+			}
+
+			if (this->rs_.reconstruct(shards, outputs, max_size))
+			{
+				for (std::size_t i = 0; i < d; ++i)
+				{
+					if (shards[i])
+						continue;
+					std::uint16_t len = fec_read_u16(outputs[i]);
+					if (len >= fec_size_size && len <= max_size)
+						input(reinterpret_cast<const char*>(outputs[i] + fec_size_size), std::size_t(len - fec_size_size));
+				}
+			}
+
+			this->_finish(*g);
+		}
+
+		inline void _finish(group & g)
+		{
+			g.done = true;
+			for (std::vector<std::uint8_t> & x : g.shards)
+			{
+				x.clear();
+				x.shrink_to_fit();
+			}
+		}
+
+	protected:
+		reed_solomon                           rs_;
+
+		std::uint32_t                          shard_count_;
+
+		/// the seqid wraps at a multiple of the shard count, so a group never crosses the wrap
+		std::uint32_t                          paws_;
+
+		std::uint32_t                          send_seqid_ = 0;
+
+		std::size_t                            send_count_ = 0;
+
+		std::size_t                            send_max_   = 0;
+
+		/// whether no data shard is added to the partial group since the last tick
+		bool                                   send_idle_  = false;
+
+		std::vector<std::vector<std::uint8_t>> send_shards_;
+
+		std::vector<std::vector<std::uint8_t>> parity_shards_;
+
+		std::deque<group>                      groups_;
+	};
+}
+
+#endif // !__ASIO2_KCP_FEC_HPP__
@@ -26,6 +26,7 @@
 #include <asio2/base/selector.hpp>
 #include <asio2/base/error.hpp>
 #include <asio2/base/detail/condition_wrap.hpp>
+#include <asio2/base/detail/allocator.hpp>
 
 #include <asio2/udp/detail/ikcp.h>
 
@@ -83,7 +84,8 @@ namespace asio2::detail::kcp
 		std::uint16_t thf_rst : 1;
 		std::uint16_t thf_syn : 1;
 		std::uint16_t thf_fin : 1;
-		std::uint16_t th_padding : 10;
+		std::uint16_t th_fec_data : 5;     /* fec data shards, 0 means no fec */
+		std::uint16_t th_fec_parity : 5;   /* fec parity shards */
 		std::uint16_t th_sum;
 	}__KCPHDR_ONEBYTE_ALIGN__;
 #if defined(__GNUC__) || defined(__GNUG__)
@@ -176,11 +178,13 @@ namespace asio2::detail::kcp
 	}
 
 	template<typename = void>
-	inline kcphdr make_kcphdr_syn(std::uint32_t seq)
+	inline kcphdr make_kcphdr_syn(std::uint32_t seq, std::uint8_t fec_data = 0, std::uint8_t fec_parity = 0)
 	{
 		kcphdr hdr = { 0 };
 		hdr.th_seq = seq;
 		hdr.thf_syn = 1;
+		hdr.th_fec_data = fec_data & 0x1f;
+		hdr.th_fec_parity = fec_parity & 0x1f;
 		hdr.th_sum = checksum(reinterpret_cast<unsigned short *>(&hdr),
 			static_cast<int>(sizeof(kcphdr) - sizeof(kcphdr::th_sum)));
 
@@ -188,13 +192,16 @@ namespace asio2::detail::kcp
 	}
 
 	template<typename = void>
-	inline kcphdr make_kcphdr_synack(std::uint32_t seq, std::uint32_t ack)
+	inline kcphdr make_kcphdr_synack(std::uint32_t seq, std::uint32_t ack,
+		std::uint8_t fec_data = 0, std::uint8_t fec_parity = 0)
 	{
 		kcphdr hdr = { 0 };
 		hdr.th_seq = seq;
 		hdr.th_ack = ack + 1;
 		hdr.thf_ack = 1;
 		hdr.thf_syn = 1;
+		hdr.th_fec_data = fec_data & 0x1f;
+		hdr.th_fec_parity = fec_parity & 0x1f;
 		hdr.th_sum = checksum(reinterpret_cast<unsigned short *>(&hdr),
 			static_cast<int>(sizeof(kcphdr) - sizeof(kcphdr::th_sum)));
 
@@ -202,9 +209,10 @@ namespace asio2::detail::kcp
 	}
 
 	template<typename = void>
-	inline kcphdr make_kcphdr_ack(std::uint32_t ack)
+	inline kcphdr make_kcphdr_ack(std::uint32_t ack, std::uint32_t seq = 0)
 	{
 		kcphdr hdr = { 0 };
+		hdr.th_seq = seq;
 		hdr.th_ack = ack + 1;
 		hdr.thf_ack = 1;
 		hdr.th_sum = checksum(reinterpret_cast<unsigned short *>(&hdr),
@@ -225,10 +233,65 @@ namespace asio2::detail::kcp
 		return hdr;
 	}
 
+	/**
+	 * The transport statistics of a kcp session.
+	 */
+	struct kcp_stats
+	{
+		std::uint32_t srtt             = 0; // the smoothed rtt, unit : millisecond
+		std::uint32_t rttvar           = 0; // the rtt variation, unit : millisecond
+		std::uint32_t rto              = 0; // the retransmission timeout, unit : millisecond
+		std::uint32_t retransmits      = 0; // the count of the timeout retransmissions
+		std::uint32_t fast_retransmits = 0; // the count of the fast retransmissions
+		std::uint32_t inflight         = 0; // the segments which are sent but not acked
+		std::uint32_t snd_queue        = 0; // the segments which are waiting for sending
+		std::uint32_t rcv_queue        = 0; // the segments which are waiting for reading
+		std::uint32_t rcv_buf          = 0; // the out of order segments
+		std::uint32_t cwnd             = 0; // the congestion window
+		std::uint32_t rmt_wnd          = 0; // the remote recv window
+	};
+
+	/**
+	 * The kcp allocates a segment for each sent, received, acked and retransmitted datagram, so the
+	 * memory of the kcp is allocated from the recycling handler pool of the current thread instead
+	 * of the heap. A segment is less than 2048 bytes with the default mtu, so it's always served
+	 * by the size classes of the pool.
+	 */
+	inline void * kcp_malloc(std::size_t size)
+	{
+		return handler_pool::allocate(size);
+	}
+
+	inline void kcp_free(void * p)
+	{
+		handler_pool::deallocate(p);
+	}
+
+	/**
+	 * @function : install the pooled allocator into the kcp, it's installed only once, and it's
+	 * not installed if the user has installed a custom allocator already.
+	 */
+	inline void kcp_install_allocator()
+	{
+		static bool installed = []()
+		{
+			if (ikcp_malloc_hook == nullptr && ikcp_free_hook == nullptr)
+				ikcp_allocator(&kcp_malloc, &kcp_free);
+			return true;
+		}();
+
+		std::ignore = installed;
+	}
+
 	struct kcp_deleter
 	{
 		inline void operator()(ikcpcb* p) const { kcp::ikcp_release(p); };
 	};
 }
 
+namespace asio2
+{
+	using kcp_stats = detail::kcp::kcp_stats;
+}
+
 #endif // !__ASIO2_KCP_UTIL_HPP__
@@ -0,0 +1,487 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_UDP_MMSG_HPP__
+#define __ASIO2_UDP_MMSG_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <vector>
+#include <string_view>
+
+#include <asio2/base/selector.hpp>
+#include <asio2/base/error.hpp>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#endif
+
+namespace asio2::detail
+{
+	/// the max count of datagrams which are received or sent by one recvmmsg/sendmmsg call
+	static std::size_t constexpr udp_mmsg_batch_size = 32;
+
+	/// the max count of the segments which are sent by one UDP_SEGMENT datagram
+	static std::size_t constexpr udp_gso_max_segments = 64;
+
+	/// the max size of the UDP_SEGMENT datagram and the UDP_GRO coalesced datagram
+	static std::size_t constexpr udp_gso_max_size = 65000;
+	static std::size_t constexpr udp_gro_buffer_size = 65535;
+
+#if defined(__linux__)
+	/// the socket options of the segmentation offload, the old headers may not define them
+	#if defined(UDP_SEGMENT)
+	static int constexpr udp_segment_option = UDP_SEGMENT;
+	#else
+	static int constexpr udp_segment_option = 103;
+	#endif
+
+	#if defined(UDP_GRO)
+	static int constexpr udp_gro_option = UDP_GRO;
+	#else
+	static int constexpr udp_gro_option = 104;
+	#endif
+#endif
+
+	/**
+	 * @function : check whether the kernel supports the UDP_SEGMENT (the generic segmentation
+	 * offload) for the socket
+	 */
+	template<class Socket>
+	inline bool udp_gso_supported(Socket& socket)
+	{
+	#if defined(__linux__)
+		int value = 0;
+		socklen_t len = sizeof(value);
+		return (::getsockopt(socket.native_handle(), IPPROTO_UDP, udp_segment_option, &value, &len) == 0);
+	#else
+		std::ignore = socket;
+		return false;
+	#endif
+	}
+
+	/**
+	 * @function : enable the UDP_GRO (the generic receive offload) of the socket, the kernel
+	 * coalesces the datagrams of a flow into one large buffer with the segment size
+	 * @return   : false if it's not supported
+	 */
+	template<class Socket>
+	inline bool udp_enable_gro(Socket& socket)
+	{
+	#if defined(__linux__)
+		int value = 1;
+		return (::setsockopt(socket.native_handle(), IPPROTO_UDP, udp_gro_option, &value, sizeof(value)) == 0);
+	#else
+		std::ignore = socket;
+		return false;
+	#endif
+	}
+
+	/**
+	 * Receive the pending datagrams of a udp socket with one recvmmsg call, the datagrams are
+	 * stored in a slab of preallocated buffers, each buffer can hold the max udp datagram, so the
+	 * slab is allocated once and isn't changed with the recv buffer size of the caller. On the platforms which don't support recvmmsg,
+	 * nothing is received, and the caller just uses the normal async_receive path.
+	 * If the UDP_GRO is enabled, the coalesced datagrams are split by the segment size which is
+	 * passed by the kernel, so the handler still gets the original datagrams.
+	 */
+	class udp_mmsg_recver
+	{
+	public:
+		udp_mmsg_recver() = default;
+		~udp_mmsg_recver() = default;
+
+		udp_mmsg_recver(const udp_mmsg_recver&) = delete;
+		udp_mmsg_recver& operator=(const udp_mmsg_recver&) = delete;
+
+		/**
+		 * @function : set whether the UDP_GRO is enabled for the socket, all the datagrams must be
+		 * received by the recv function, because the normal async_receive can't get the segment size.
+		 */
+		inline void set_gro(bool enable)
+		{
+		#if defined(__linux__)
+			this->gro_ = enable;
+		#else
+			std::ignore = enable;
+		#endif
+		}
+
+		/**
+		 * @function : check whether the UDP_GRO is enabled
+		 */
+		inline bool is_gro() const
+		{
+		#if defined(__linux__)
+			return this->gro_;
+		#else
+			return false;
+		#endif
+		}
+
+		/**
+		 * @function : receive the pending datagrams without blocking, and call the handler for each.
+		 * @param    : socket - the udp socket
+		 * @param    : buffer_size - the max size of each datagram which is passed to the handler, the
+		 * larger part is truncated, like the normal async_receive into the recv buffer
+		 * @param    : handler - Function signature : void(asio::ip::udp::endpoint& endpoint, std::string_view s)
+		 * @return   : the count of the received datagrams
+		 */
+		template<class Socket, class Function>
+		inline std::size_t recv(Socket& socket, std::size_t buffer_size, Function&& handler)
+		{
+		#if defined(__linux__)
+			if (!socket.is_open() || buffer_size == 0)
+				return 0;
+
+			// the datagrams and the coalesced datagrams are up to 64KB
+			std::size_t slot_size = udp_gro_buffer_size;
+
+			this->_prepare();
+
+			int n = ::recvmmsg(socket.native_handle(), this->msgs_.data(),
+				static_cast<unsigned int>(udp_mmsg_batch_size), MSG_DONTWAIT, nullptr);
+			if (n <= 0)
+				return 0;
+
+			for (int i = 0; i < n; ++i)
+			{
+				asio::ip::udp::endpoint & endpoint = this->endpoints_[i];
+				endpoint.resize(static_cast<std::size_t>(this->msgs_[i].msg_hdr.msg_namelen));
+
+				const char * data = this->slab_.data() + i * slot_size;
+				std::size_t bytes_recvd = (std::min<std::size_t>)(this->msgs_[i].msg_len, slot_size);
+
+				std::size_t segment_size = this->gro_ ? this->_segment_size(this->msgs_[i].msg_hdr) : 0;
+				if (segment_size == 0)
+					segment_size = bytes_recvd;
+
+				// the segment boundaries are passed to the handler one by one
+				std::size_t offset = 0;
+				do
+				{
+					std::size_t size = (std::min<std::size_t>)(segment_size, bytes_recvd - offset);
+					handler(endpoint, std::string_view(data + offset, (std::min<std::size_t>)(size, buffer_size)));
+					offset += size;
+				} while (offset < bytes_recvd);
+			}
+
+			return static_cast<std::size_t>(n);
+		#else
+			std::ignore = socket;
+			std::ignore = buffer_size;
+			std::ignore = handler;
+			return 0;
+		#endif
+		}
+
+	protected:
+	#if defined(__linux__)
+		static constexpr std::size_t control_size = CMSG_SPACE(sizeof(int));
+
+		inline std::size_t _segment_size(struct msghdr & hdr)
+		{
+			for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+			{
+				if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == udp_gro_option)
+				{
+					int segment_size = 0;
+					std::memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(int));
+					return static_cast<std::size_t>(segment_size > 0 ? segment_size : 0);
+				}
+			}
+			return 0;
+		}
+
+		inline void _prepare()
+		{
+			if (this->msgs_.empty())
+			{
+				std::size_t buffer_size = udp_gro_buffer_size;
+
+				this->slab_.resize(udp_mmsg_batch_size * buffer_size);
+				this->iovs_.resize(udp_mmsg_batch_size);
+				this->msgs_.resize(udp_mmsg_batch_size);
+				this->endpoints_.resize(udp_mmsg_batch_size);
+				this->control_.resize(udp_mmsg_batch_size * control_size);
+
+				for (std::size_t i = 0; i < udp_mmsg_batch_size; ++i)
+				{
+					this->iovs_[i].iov_base = this->slab_.data() + i * buffer_size;
+					this->iovs_[i].iov_len  = buffer_size;
+				}
+			}
+
+			// the msg_namelen and msg_flags are modified by recvmmsg, so we must reset them every time.
+			for (std::size_t i = 0; i < udp_mmsg_batch_size; ++i)
+			{
+				std::memset(&(this->msgs_[i]), 0, sizeof(struct mmsghdr));
+				this->msgs_[i].msg_hdr.msg_name    = this->endpoints_[i].data();
+				this->msgs_[i].msg_hdr.msg_namelen = static_cast<socklen_t>(this->endpoints_[i].capacity());
+				this->msgs_[i].msg_hdr.msg_iov     = &(this->iovs_[i]);
+				this->msgs_[i].msg_hdr.msg_iovlen  = 1;
+				if (this->gro_)
+				{
+					this->msgs_[i].msg_hdr.msg_control    = this->control_.data() + i * control_size;
+					this->msgs_[i].msg_hdr.msg_controllen = control_size;
+				}
+			}
+		}
+
+	protected:
+		bool                                 gro_ = false;
+
+		std::vector<char>                    slab_;
+
+		std::vector<struct iovec>            iovs_;
+
+		std::vector<struct mmsghdr>          msgs_;
+
+		std::vector<asio::ip::udp::endpoint> endpoints_;
+
+		std::vector<char>                    control_;
+	#endif
+	};
+
+	/**
+	 * Collect the datagrams which are sent in one handler run, and send them with one sendmmsg
+	 * call when the handler run ends. One sender is used by all the sockets of a thread, because
+	 * the datagrams are always sent and flushed in the same io_context thread.
+	 * If the UDP_SEGMENT is used, the consecutive datagrams of the same destination and the same
+	 * size are sent as one large datagram, and the kernel splits it into the equal segments.
+	 * On the platforms which don't support sendmmsg, the datagram is sent immediately.
+	 */
+	class udp_mmsg_sender
+	{
+	public:
+		udp_mmsg_sender() = default;
+		~udp_mmsg_sender() = default;
+
+		udp_mmsg_sender(const udp_mmsg_sender&) = delete;
+		udp_mmsg_sender& operator=(const udp_mmsg_sender&) = delete;
+
+		/**
+		 * @function : get the sender of the current thread
+		 */
+		static inline udp_mmsg_sender & this_thread_sender()
+		{
+			thread_local udp_mmsg_sender sender;
+			return sender;
+		}
+
+		/**
+		 * @function : append a datagram to the batch
+		 * @param    : socket - the udp socket
+		 * @param    : endpoint - the destination, nullptr for the connected socket
+		 * @param    : data - the datagram
+		 * @param    : gso - whether use the UDP_SEGMENT to send the datagrams of the socket
+		 */
+		template<class Socket>
+		inline void push(Socket& socket, const asio::ip::udp::endpoint* endpoint, std::string_view data,
+			bool gso = false)
+		{
+		#if defined(__linux__)
+			if (this->fd_ != socket.native_handle() || this->gso_ != gso ||
+				this->sizes_.size() >= (gso ? udp_gso_max_segments : udp_mmsg_batch_size))
+				this->flush();
+
+			this->fd_  = socket.native_handle();
+			this->gso_ = gso;
+
+			this->endpoints_.emplace_back(endpoint ? *endpoint : asio::ip::udp::endpoint{});
+			this->connected_.emplace_back(endpoint == nullptr);
+			this->sizes_.emplace_back(data.size());
+			this->data_.insert(this->data_.end(), data.begin(), data.end());
+		#else
+			std::ignore = gso;
+			error_code ec;
+			if (endpoint)
+				socket.send_to(asio::buffer(data.data(), data.size()), *endpoint, 0, ec);
+			else
+				socket.send(asio::buffer(data.data(), data.size()), 0, ec);
+		#endif
+		}
+
+		/**
+		 * @function : flush the batch after the current handler run of the strand ends, so the
+		 * datagrams which are generated by many handlers in one run are sent by one sendmmsg call.
+		 * The strand must be the strand of the io_context of the current thread.
+		 */
+		template<class Strand>
+		inline void post_flush(Strand& strand)
+		{
+		#if defined(__linux__)
+			if (this->flush_posted_)
+				return;
+
+			this->flush_posted_ = true;
+
+			asio::post(strand, [this]()
+			{
+				this->flush_posted_ = false;
+				this->flush();
+			});
+		#else
+			std::ignore = strand;
+		#endif
+		}
+
+		/**
+		 * @function : send all the datagrams of the batch
+		 */
+		inline void flush()
+		{
+		#if defined(__linux__)
+			std::size_t total = this->sizes_.size();
+			if (total == 0)
+				return;
+
+			struct iovec   iovs[udp_gso_max_segments];
+			struct mmsghdr msgs[udp_gso_max_segments];
+			std::uint16_t  segs[udp_gso_max_segments];
+			char           ctrl[udp_gso_max_segments][CMSG_SPACE(sizeof(std::uint16_t))];
+
+			std::memset(msgs, 0, sizeof(struct mmsghdr) * total);
+
+			// the count of the messages, it's less than the count of the datagrams if the
+			// datagrams are coalesced
+			std::size_t count = 0;
+
+			std::size_t offset = 0;
+			for (std::size_t i = 0; i < total; ++count)
+			{
+				// coalesce the following datagrams which have the same destination, all the segments
+				// must have the same size except the last one which may be smaller.
+				std::size_t j = i + 1, bytes = this->sizes_[i];
+				if (this->gso_)
+				{
+					while (j < total && bytes + this->sizes_[j] <= udp_gso_max_size &&
+						this->sizes_[j - 1] == this->sizes_[i] && this->sizes_[j] <= this->sizes_[i] &&
+						this->connected_[j] == this->connected_[i] &&
+						(this->connected_[i] || this->endpoints_[j] == this->endpoints_[i]))
+					{
+						bytes += this->sizes_[j];
+						++j;
+					}
+				}
+
+				iovs[count].iov_base = this->data_.data() + offset;
+				iovs[count].iov_len  = bytes;
+
+				if (!this->connected_[i])
+				{
+					msgs[count].msg_hdr.msg_name    = this->endpoints_[i].data();
+					msgs[count].msg_hdr.msg_namelen = static_cast<socklen_t>(this->endpoints_[i].size());
+				}
+				msgs[count].msg_hdr.msg_iov    = &iovs[count];
+				msgs[count].msg_hdr.msg_iovlen = 1;
+
+				segs[count] = 0;
+				if (j - i > 1)
+				{
+					segs[count] = static_cast<std::uint16_t>(this->sizes_[i]);
+
+					msgs[count].msg_hdr.msg_control    = ctrl[count];
+					msgs[count].msg_hdr.msg_controllen = sizeof(ctrl[count]);
+
+					struct cmsghdr * cmsg = CMSG_FIRSTHDR(&(msgs[count].msg_hdr));
+					cmsg->cmsg_level = IPPROTO_UDP;
+					cmsg->cmsg_type  = udp_segment_option;
+					cmsg->cmsg_len   = CMSG_LEN(sizeof(std::uint16_t));
+					std::memcpy(CMSG_DATA(cmsg), &segs[count], sizeof(std::uint16_t));
+				}
+
+				offset += bytes;
+				i = j;
+			}
+
+			std::size_t sent = 0;
+			while (sent < count)
+			{
+				int n = ::sendmmsg(this->fd_, msgs + sent, static_cast<unsigned int>(count - sent), 0);
+				if (n > 0)
+				{
+					sent += static_cast<std::size_t>(n);
+				}
+				else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				{
+					// the socket is in non-blocking mode when it has pending async operations, so
+					// we wait until it's writable, as the blocking send_to does.
+					struct pollfd fds;
+					fds.fd = this->fd_;
+					fds.events = POLLOUT;
+					fds.revents = 0;
+					if (::poll(&fds, 1, -1) < 0 && errno != EINTR)
+						break;
+				}
+				else if (n < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				else
+				{
+					// the segmentation offload is not available for the route (eg : the device
+					// doesn't support the checksum offload), send the segments one by one.
+					if (segs[sent] != 0 && (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP))
+						this->_send_segments(msgs[sent].msg_hdr, segs[sent]);
+
+					// the first datagram failed, discard it and send the others, as the udp does.
+					++sent;
+				}
+			}
+
+			this->endpoints_.clear();
+			this->connected_.clear();
+			this->sizes_.clear();
+			this->data_.clear();
+		#endif
+		}
+
+	protected:
+	#if defined(__linux__)
+		inline void _send_segments(struct msghdr & hdr, std::size_t segment_size)
+		{
+			const char * data = static_cast<const char *>(hdr.msg_iov->iov_base);
+			std::size_t  size = hdr.msg_iov->iov_len;
+			for (std::size_t offset = 0; offset < size; offset += segment_size)
+			{
+				::sendto(this->fd_, data + offset, (std::min<std::size_t>)(segment_size, size - offset), 0,
+					static_cast<const struct sockaddr *>(hdr.msg_name), hdr.msg_namelen);
+			}
+		}
+
+	protected:
+		int                                  fd_ = -1;
+
+		bool                                 gso_ = false;
+
+		bool                                 flush_posted_ = false;
+
+		std::vector<asio::ip::udp::endpoint> endpoints_;
+
+		std::vector<bool>                    connected_;
+
+		std::vector<std::size_t>             sizes_;
+
+		std::vector<char>                    data_;
+	#endif
+	};
+}
+
+#endif // !__ASIO2_UDP_MMSG_HPP__
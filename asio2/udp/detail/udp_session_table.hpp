@@ -0,0 +1,241 @@
+/*
+ * COPYRIGHT (C) 2017-2019, zhllxt
+ *
+ * author   : zhllxt
+ * email    : 37792738@qq.com
+ *
+ * Distributed under the GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+ * (See accompanying file LICENSE or see <http://www.gnu.org/licenses/>)
+ */
+
+#ifndef __ASIO2_UDP_SESSION_TABLE_HPP__
+#define __ASIO2_UDP_SESSION_TABLE_HPP__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <asio2/base/selector.hpp>
+
+namespace asio2::detail
+{
+	/**
+	 * The endpoint to session dispatch table of the udp server, it's owned by the io_context which
+	 * receives the datagrams, the sessions are inserted and erased on the strand of that io (where
+	 * the session_mgr inserts and erases them), and are found on the same strand, so no lock is used.
+	 * It's an open addressing hash table with linear probing, the key is the endpoint packed into
+	 * three integers, and the slot of the last found endpoint is cached, because the datagrams are
+	 * usually received in bursts from the same endpoint.
+	 */
+	template<class session_t>
+	class udp_session_table
+	{
+	public:
+		/**
+		 * @constructor
+		 */
+		udp_session_table()
+		{
+			this->slots_.resize(init_capacity);
+		}
+
+		/**
+		 * @destructor
+		 */
+		~udp_session_table() = default;
+
+		udp_session_table(const udp_session_table&) = delete;
+		udp_session_table& operator=(const udp_session_table&) = delete;
+
+		/**
+		 * @function : find the session by the remote endpoint
+		 */
+		inline std::shared_ptr<session_t> find(const asio::ip::udp::endpoint & endpoint)
+		{
+			key_t key = _pack(endpoint);
+
+			if (this->last_ != npos && this->slots_[this->last_].key == key)
+				return this->slots_[this->last_].session;
+
+			std::size_t i = this->_find(key);
+			if (i == npos)
+				return std::shared_ptr<session_t>();
+
+			this->last_ = i;
+			return this->slots_[i].session;
+		}
+
+		/**
+		 * @function : insert the session, the session with the same endpoint is replaced
+		 */
+		inline void emplace(const std::shared_ptr<session_t> & session_ptr)
+		{
+			key_t key = _pack(session_ptr->hash_key());
+
+			std::size_t i = this->_find(key);
+			if (i != npos)
+			{
+				this->slots_[i].session = session_ptr;
+				return;
+			}
+
+			// keep the load factor not greater than 1/2, so the probe sequences are short
+			if ((this->size_ + 1) * 2 > this->slots_.size())
+				this->_rehash(this->slots_.size() * 2);
+
+			std::size_t mask = this->slots_.size() - 1;
+			for (i = _hash(key) & mask; this->slots_[i].session; i = (i + 1) & mask);
+
+			this->slots_[i].key = key;
+			this->slots_[i].session = session_ptr;
+			++(this->size_);
+		}
+
+		/**
+		 * @function : erase the session, nothing is done if the slot is used by another session
+		 */
+		inline void erase(const std::shared_ptr<session_t> & session_ptr)
+		{
+			std::size_t i = this->_find(_pack(session_ptr->hash_key()));
+			if (i == npos || this->slots_[i].session != session_ptr)
+				return;
+
+			// the entries are moved backward, so the cached slot may be changed
+			this->last_ = npos;
+
+			// backward shift deletion, the following entries of the probe sequence are moved into
+			// the hole, so no tombstone is needed.
+			std::size_t mask = this->slots_.size() - 1;
+			std::size_t hole = i;
+			for (std::size_t j = (i + 1) & mask; this->slots_[j].session; j = (j + 1) & mask)
+			{
+				std::size_t home = _hash(this->slots_[j].key) & mask;
+				// move the entry if its home slot is not in the range (hole, j]
+				if (((j - home) & mask) >= ((j - hole) & mask))
+				{
+					this->slots_[hole] = std::move(this->slots_[j]);
+					hole = j;
+				}
+			}
+
+			this->slots_[hole].session.reset();
+			--(this->size_);
+		}
+
+		/**
+		 * @function : remove all the sessions
+		 */
+		inline void clear()
+		{
+			this->slots_.clear();
+			this->slots_.resize(init_capacity);
+			this->size_ = 0;
+			this->last_ = npos;
+		}
+
+		/**
+		 * @function : get the count of the sessions
+		 */
+		inline std::size_t size() const
+		{
+			return this->size_;
+		}
+
+	protected:
+		static constexpr std::size_t init_capacity = 64;
+		static constexpr std::size_t npos = std::size_t(-1);
+
+		struct key_t
+		{
+			std::uint64_t hi   = 0;
+			std::uint64_t lo   = 0;
+			/// port(16) | v6(1) | scope id(32)
+			std::uint64_t meta = 0;
+
+			inline bool operator==(const key_t & other) const
+			{
+				return (this->lo == other.lo && this->meta == other.meta && this->hi == other.hi);
+			}
+		};
+
+		struct slot_t
+		{
+			key_t                      key;
+			std::shared_ptr<session_t> session;
+		};
+
+		static inline key_t _pack(const asio::ip::udp::endpoint & endpoint)
+		{
+			key_t key;
+			const asio::ip::address & addr = endpoint.address();
+			key.meta = std::uint64_t(endpoint.port());
+			if (addr.is_v4())
+			{
+				key.lo = std::uint64_t(addr.to_v4().to_uint());
+			}
+			else
+			{
+				asio::ip::address_v6 v6 = addr.to_v6();
+				asio::ip::address_v6::bytes_type bytes = v6.to_bytes();
+				std::memcpy(&key.hi, bytes.data(), 8);
+				std::memcpy(&key.lo, bytes.data() + 8, 8);
+				key.meta |= (std::uint64_t(1) << 16) | (std::uint64_t(v6.scope_id()) << 32);
+			}
+			return key;
+		}
+
+		static inline std::size_t _hash(const key_t & key)
+		{
+			std::uint64_t h = key.lo ^ (key.hi * std::uint64_t(0x9E3779B97F4A7C15)) ^
+				(key.meta * std::uint64_t(0xC2B2AE3D27D4EB4F));
+			h ^= h >> 33;
+			h *= std::uint64_t(0xFF51AFD7ED558CCD);
+			h ^= h >> 33;
+			return static_cast<std::size_t>(h);
+		}
+
+		inline std::size_t _find(const key_t & key) const
+		{
+			std::size_t mask = this->slots_.size() - 1;
+			for (std::size_t i = _hash(key) & mask; this->slots_[i].session; i = (i + 1) & mask)
+			{
+				if (this->slots_[i].key == key)
+					return i;
+			}
+			return npos;
+		}
+
+		inline void _rehash(std::size_t capacity)
+		{
+			std::vector<slot_t> slots(capacity);
+			std::size_t mask = capacity - 1;
+			for (slot_t & slot : this->slots_)
+			{
+				if (!slot.session)
+					continue;
+				std::size_t i = _hash(slot.key) & mask;
+				while (slots[i].session)
+					i = (i + 1) & mask;
+				slots[i] = std::move(slot);
+			}
+			this->slots_ = std::move(slots);
+			this->last_ = npos;
+		}
+
+	protected:
+		/// the slots, the count is power of 2, the slot is empty if the session is nullptr
+		std::vector<slot_t> slots_;
+
+		std::size_t         size_ = 0;
+
+		/// the slot of the last found endpoint
+		std::size_t         last_ = npos;
+	};
+}
+
+#endif // !__ASIO2_UDP_SESSION_TABLE_HPP__
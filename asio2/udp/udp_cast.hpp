@@ -47,7 +47,9 @@
 
 #include <asio2/base/detail/linear_buffer.hpp>
 #include <asio2/udp/component/udp_send_cp.hpp>
+#include <asio2/udp/component/udp_mcast_cp.hpp>
 #include <asio2/udp/impl/udp_send_op.hpp>
+#include <asio2/udp/detail/udp_mmsg.hpp>
 
 namespace asio2::detail
 {
@@ -63,12 +65,14 @@ namespace asio2::detail
 		, public post_cp<derived_t>
 		, public udp_send_cp<derived_t, false>
 		, public udp_send_op<derived_t, false>
+		, public udp_mcast_cp<derived_t>
 	{
 		template <class, bool>         friend class user_timer_cp;
 		template <class>               friend class data_persistence_cp;
 		template <class>               friend class event_queue_cp;
 		template <class, bool>         friend class udp_send_cp;
 		template <class, bool>         friend class udp_send_op;
+		template <class>               friend class udp_mcast_cp;
 		template <class>               friend class post_cp;
 
 	public:
@@ -88,15 +92,44 @@ namespace asio2::detail
 			, event_queue_cp<derived_t>()
 			, user_data_cp<derived_t>()
 			, active_time_cp<derived_t>()
-			, socket_cp<derived_t, socket_t>(iopool_.get(0).context())
-			, user_timer_cp<derived_t, false>(iopool_.get(0))
+			, socket_cp<derived_t, socket_t>(iopool_.get(iopool_index_).context())
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
 			, post_cp<derived_t>()
-			, udp_send_cp<derived_t, false>(iopool_.get(0))
+			, udp_send_cp<derived_t, false>(iopool_.get(iopool_index_))
 			, udp_send_op<derived_t, false>()
+			, udp_mcast_cp<derived_t>()
 			, rallocator_()
 			, wallocator_()
 			, listener_()
-			, io_(iopool_.get(0))
+			, io_(iopool_.get(iopool_index_))
+			, buffer_(init_buffer_size, max_buffer_size)
+		{
+		}
+
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many objects
+		 */
+		explicit udp_cast_impl_t(
+			iopool & pool,
+			std::size_t init_buffer_size = udp_frame_size,
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: super()
+			, iopool_cp(pool)
+			, event_queue_cp<derived_t>()
+			, user_data_cp<derived_t>()
+			, active_time_cp<derived_t>()
+			, socket_cp<derived_t, socket_t>(iopool_.get(iopool_index_).context())
+			, user_timer_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, post_cp<derived_t>()
+			, udp_send_cp<derived_t, false>(iopool_.get(iopool_index_))
+			, udp_send_op<derived_t, false>()
+			, udp_mcast_cp<derived_t>()
+			, rallocator_()
+			, wallocator_()
+			, listener_()
+			, io_(iopool_.get(iopool_index_))
 			, buffer_(init_buffer_size, max_buffer_size)
 		{
 		}
@@ -143,7 +176,7 @@ namespace asio2::detail
 		{
 			this->derived()._do_stop(asio::error::operation_aborted);
 
-			this->iopool_.stop();
+			this->_stop_iopool(this->io_, [this]() { return this->derived().is_stopped(); });
 		}
 
 		/**
@@ -251,6 +284,8 @@ namespace asio2::detail
 
 				this->socket_.close(ec_ignore);
 
+				this->derived()._mcast_start();
+
 				std::string h = to_string(std::forward<String>(host));
 				std::string p = to_string(std::forward<StrOrInt>(service));
 
@@ -360,6 +395,9 @@ namespace asio2::detail
 			// close user custom timers
 			this->stop_all_timers();
 
+			// send the messages which are packed by the publisher
+			this->derived()._mcast_stop();
+
 			// destroy user data, maybe the user data is self shared_ptr, if don't destroy it, will cause loop refrence.
 			this->user_data_.reset();
 
@@ -426,6 +464,21 @@ namespace asio2::detail
 
 			this->buffer_.consume(this->buffer_.size());
 
+			// drain the other pending datagrams with one recvmmsg call
+			if (!ec)
+			{
+				this->mmsg_recver_.recv(this->socket_, this->buffer_.pre_size(),
+					[this](asio::ip::udp::endpoint& endpoint, std::string_view s)
+				{
+					if (!this->is_started())
+						return;
+
+					this->remote_endpoint_ = endpoint;
+
+					this->derived()._fire_recv(std::shared_ptr<derived_t>{}, s);
+				});
+			}
+
 			this->derived()._post_recv(condition);
 		}
 
@@ -436,6 +489,9 @@ namespace asio2::detail
 
 		inline void _fire_recv(std::shared_ptr<derived_t>, std::string_view s)
 		{
+			if (this->derived()._mcast_handle_recv(this->remote_endpoint_, s))
+				return;
+
 			this->listener_.notify(event::recv, this->remote_endpoint_, s);
 		}
 
@@ -495,6 +551,9 @@ namespace asio2::detail
 
 		/// endpoint for udp 
 		asio::ip::udp::endpoint                     remote_endpoint_;
+
+		/// used to receive the pending datagrams with one recvmmsg call
+		udp_mmsg_recver                             mmsg_recver_;
 	};
 }
 
@@ -18,7 +18,9 @@
 #include <asio2/base/client.hpp>
 #include <asio2/base/detail/linear_buffer.hpp>
 #include <asio2/udp/impl/udp_send_op.hpp>
+#include <asio2/udp/component/udp_batch_cp.hpp>
 #include <asio2/udp/detail/kcp_util.hpp>
+#include <asio2/udp/detail/udp_mmsg.hpp>
 #include <asio2/udp/component/kcp_stream_cp.hpp>
 
 namespace asio2::detail
@@ -27,6 +29,7 @@ namespace asio2::detail
 	class udp_client_impl_t
 		: public client_impl_t<derived_t, socket_t, buffer_t>
 		, public udp_send_op<derived_t, false>
+		, public udp_batch_cp<derived_t, false>
 	{
 		template <class, bool>                friend class user_timer_cp;
 		template <class>                      friend class post_cp;
@@ -37,6 +40,7 @@ namespace asio2::detail
 		template <class>                      friend class event_queue_cp;
 		template <class, bool>                friend class send_cp;
 		template <class, bool>                friend class udp_send_op;
+		template <class, bool>                friend class udp_batch_cp;
 		template <class, bool>                friend class kcp_stream_cp;
 		template <class, class, class>        friend class client_impl_t;
 
@@ -55,6 +59,22 @@ namespace asio2::detail
 		)
 			: super(1, init_buffer_size, max_buffer_size)
 			, udp_send_op<derived_t, false>()
+			, udp_batch_cp<derived_t, false>(this->io_)
+		{
+		}
+
+		/**
+		 * @constructor
+		 * @param    : pool - a user supplied io_context pool which can be shared by many clients
+		 */
+		explicit udp_client_impl_t(
+			iopool & pool,
+			std::size_t init_buffer_size = udp_frame_size,
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+		)
+			: super(pool, init_buffer_size, max_buffer_size)
+			, udp_send_op<derived_t, false>()
+			, udp_batch_cp<derived_t, false>(this->io_)
 		{
 		}
 
@@ -144,7 +164,7 @@ namespace asio2::detail
 			// This will result in an ungraceful close.
 			this->derived()._do_stop(asio::error::operation_aborted);
 
-			this->iopool_.stop();
+			this->_stop_iopool(this->io_, [this]() { return this->derived().is_stopped(); });
 		}
 
 	public:
@@ -159,6 +179,50 @@ namespace asio2::detail
 			return (this->kcp_ ? this->kcp_->kcp_ : nullptr);
 		}
 
+		/**
+		 * @function : get the kcp options, just used for kcp mode
+		 */
+		inline detail::kcp_option kcp_option() const
+		{
+			return (this->kcp_ ? this->kcp_->_get_option() : detail::kcp_option{});
+		}
+
+		/**
+		 * @function : change the kcp options at runtime, just used for kcp mode
+		 * eg : kcp_option(asio2::kcp_option::normal()) for the bulk transfer.
+		 */
+		inline derived_t & kcp_option(const detail::kcp_option & opt)
+		{
+			if (this->kcp_)
+				this->kcp_->_set_option(opt);
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the transport statistics of the kcp, just used for kcp mode
+		 */
+		inline kcp::kcp_stats kcp_stats() const
+		{
+			return (this->kcp_ ? this->kcp_->_get_stats() : kcp::kcp_stats{});
+		}
+
+		/**
+		 * @function : set whether use the segmentation offload of the linux kernel, the kcp datagrams
+		 * are sent by one UDP_SEGMENT datagram, and the received datagrams are coalesced by UDP_GRO,
+		 * it reduces the per datagram cost of the bulk transfer. It's ignored if the kernel doesn't
+		 * support it. This function must be called before the client starts.
+		 */
+		inline derived_t & segment_offload(bool enable)
+		{
+			this->segment_offload_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the segmentation offload is enabled
+		 */
+		inline bool is_segment_offload() const { return this->segment_offload_; }
+
 	public:
 		/**
 		 * @function : bind recv listener
@@ -331,6 +395,9 @@ namespace asio2::detail
 		{
 			detail::ignore::unused(ec);
 
+			// send the pending packed datagram
+			this->derived()._batch_stop();
+
 			if (this->kcp_)
 				this->kcp_->_kcp_stop(std::move(this_ptr));
 		}
@@ -382,6 +449,10 @@ namespace asio2::detail
 		{
 			detail::ignore::unused(ec, this_ptr);
 
+			// the datagrams which are queued in the sender of this thread hold the handle of the
+			// socket, send them before the socket is closed.
+			udp_mmsg_sender::this_thread_sender().flush();
+
 			// call socket's close function to notify the _handle_recv function response with 
 			// error > 0 ,then the socket can get notify to exit
 			// Call shutdown() to indicate that you will not write any more data to the socket.
@@ -393,6 +464,10 @@ namespace asio2::detail
 		template<typename MatchCondition>
 		inline void _start_recv(std::shared_ptr<derived_t> this_ptr, condition_wrap<MatchCondition> condition)
 		{
+			// enable the segmentation offload if it's supported by the kernel
+			this->gso_ = (this->segment_offload_ && udp_gso_supported(this->socket_));
+			this->mmsg_recver_.set_gro(this->segment_offload_ && udp_enable_gro(this->socket_));
+
 			// Connect succeeded. post recv request.
 			asio::post(this->io_.strand(), [this, this_ptr, condition]()
 			{
@@ -406,7 +481,11 @@ namespace asio2::detail
 		inline bool _do_send(Data& data, Callback&& callback)
 		{
 			if (!this->kcp_)
+			{
+				if (this->is_batch())
+					return this->derived()._batch_send(data, std::forward<Callback>(callback));
 				return this->derived()._udp_send(data, std::forward<Callback>(callback));
+			}
 			return this->kcp_->_kcp_send(data, std::forward<Callback>(callback));
 		}
 
@@ -419,6 +498,18 @@ namespace asio2::detail
 
 			try
 			{
+				// the coalesced datagrams must be received by recvmmsg which gets the segment size
+				if (this->mmsg_recver_.is_gro())
+				{
+					this->socket_.async_wait(asio::socket_base::wait_read,
+						asio::bind_executor(this->io_.strand(), make_allocator(this->rallocator_,
+							[this, self_ptr = std::move(this_ptr), condition](const error_code & ec)
+					{
+						this->derived()._handle_recv(ec, 0, std::move(self_ptr), condition);
+					})));
+					return;
+				}
+
 				this->socket_.async_receive(this->buffer_.prepare(this->buffer_.pre_size()),
 					asio::bind_executor(this->io_.strand(), make_allocator(this->rallocator_,
 						[this, self_ptr = std::move(this_ptr), condition](const error_code & ec, std::size_t bytes_recvd)
@@ -450,39 +541,74 @@ namespace asio2::detail
 
 			this->buffer_.commit(bytes_recvd);
 
+			if (!ec && !this->mmsg_recver_.is_gro())
+			{
+				this->derived()._handle_datagram(this_ptr, std::string_view(static_cast
+					<std::string_view::const_pointer>(this->buffer_.data().data()), bytes_recvd), condition);
+			}
+
+			this->buffer_.consume(this->buffer_.size());
+
+			// drain the other pending datagrams with one recvmmsg call
 			if (!ec)
 			{
-				this->reset_active_time();
+				this->mmsg_recver_.recv(this->socket_, this->buffer_.pre_size(),
+					[this, &this_ptr, &condition](asio::ip::udp::endpoint&, std::string_view s)
+				{
+					this->derived()._handle_datagram(this_ptr, s, condition);
+				});
+			}
+
+			// send the kcp datagrams which are generated in this handler run
+			udp_mmsg_sender::this_thread_sender().flush();
+
+			this->derived()._post_recv(std::move(this_ptr), condition);
+		}
+
+		template<typename MatchCondition>
+		inline void _handle_datagram(std::shared_ptr<derived_t>& this_ptr, std::string_view s,
+			condition_wrap<MatchCondition> condition)
+		{
+			detail::ignore::unused(condition);
+
+			if (!this->is_started())
+				return;
 
-				std::string_view s = std::string_view(static_cast<std::string_view::const_pointer>
-					(this->buffer_.data().data()), bytes_recvd);
+			this->reset_active_time();
 
-				if constexpr (!std::is_same_v<MatchCondition, use_kcp_t>)
+			if constexpr (!std::is_same_v<MatchCondition, use_kcp_t>)
+			{
+				// split the packed datagram if the batching is enabled
+				if (!this->derived()._batch_recv(s, [this, &this_ptr](std::string_view msg)
+				{
+					this->derived()._fire_recv(this_ptr, std::move(msg));
+				}))
 				{
 					this->derived()._fire_recv(this_ptr, std::move(s));
 				}
-				else
+			}
+			else
+			{
+				if (s.size() == sizeof(kcp::kcphdr))
 				{
-					if (s.size() == sizeof(kcp::kcphdr))
+					if /**/ (kcp::is_kcphdr_fin(s))
 					{
-						if /**/ (kcp::is_kcphdr_fin(s))
-						{
-							this->kcp_->send_fin_ = false;
-							this->derived()._do_disconnect(asio::error::eof);
-						}
-						else if (kcp::is_kcphdr_synack(s, this->kcp_->seq_))
-						{
-							ASIO2_ASSERT(false);
-						}
+						this->kcp_->send_fin_ = false;
+						this->derived()._do_disconnect(asio::error::eof);
+					}
+					// the server confirms the ack of the handshake
+					else if (this->kcp_->kcp_ && kcp::is_kcphdr_ack(s, this->kcp_->kcp_->conv))
+					{
+						this->kcp_->_stop_ack_timer();
 					}
-					else
-						this->kcp_->_kcp_recv(this_ptr, s, this->buffer_);
+				}
+				else
+				{
+					// the server has created the session if it sends the kcp data
+					this->kcp_->_stop_ack_timer();
+					this->kcp_->_kcp_recv(this_ptr, s, this->buffer_);
 				}
 			}
-
-			this->buffer_.consume(this->buffer_.size());
-
-			this->derived()._post_recv(std::move(this_ptr), condition);
 		}
 
 		inline void _fire_init()
@@ -512,6 +638,13 @@ namespace asio2::detail
 
 	protected:
 		std::unique_ptr<kcp_stream_cp<derived_t, false>> kcp_;
+
+		/// used to receive the pending datagrams with one recvmmsg call
+		udp_mmsg_recver                                  mmsg_recver_;
+
+		/// whether use the segmentation offload, and whether the UDP_SEGMENT is supported
+		bool                                             segment_offload_ = false;
+		bool                                             gso_ = false;
 	};
 }
 
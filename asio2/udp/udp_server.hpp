@@ -18,6 +18,9 @@
 #include <asio2/base/server.hpp>
 #include <asio2/udp/udp_session.hpp>
 #include <asio2/base/detail/linear_buffer.hpp>
+#include <asio2/udp/detail/udp_mmsg.hpp>
+#include <asio2/udp/detail/kcp_cookie.hpp>
+#include <asio2/udp/detail/udp_session_table.hpp>
 
 namespace asio2::detail
 {
@@ -33,14 +36,69 @@ namespace asio2::detail
 		using super = server_impl_t<derived_t, session_t>;
 		using session_type = session_t;
 
+		/**
+		 * A SO_REUSEPORT udp socket which is running on its own io_context, it has its own
+		 * receive buffer and session map, all the sessions of it are running on the same
+		 * io_context too.
+		 */
+		struct reuse_socket
+		{
+			explicit reuse_socket(io_t & io, std::size_t init_buffer_size, std::size_t max_buffer_size)
+				: io_(io)
+				, socket_(io.context())
+				, remote_endpoint_()
+				, buffer_(init_buffer_size, max_buffer_size)
+				, sessions_(io)
+				, table_()
+				, rallocator_()
+				, wallocator_()
+				, counter_ptr_()
+				, mmsg_recver_()
+			{
+			}
+
+			/// the io_context which the socket and the sessions of it are running on
+			io_t                                      & io_;
+
+			/// socket to recv the datagrams
+			asio::ip::udp::socket                       socket_;
+
+			/// endpoint for udp 
+			asio::ip::udp::endpoint                     remote_endpoint_;
+
+			/// buffer
+			asio2::buffer_wrap<asio2::linear_buffer>    buffer_;
+
+			/// the sessions which are accepted by this socket
+			session_mgr_t<session_t>                    sessions_;
+
+			/// the endpoint to session dispatch table, it's only accessed in the io_context thread of this socket
+			udp_session_table<session_t>                table_;
+
+			/// The memory to use for handler-based custom memory allocation. used for recv.
+			handler_memory<>                            rallocator_;
+
+			/// The memory to use for handler-based custom memory allocation. used fo post.
+			handler_memory<size_op<>, std::true_type>   wallocator_;
+
+			/// the server's counter, it's only accessed in the io_context thread of this socket
+			std::shared_ptr<void>                       counter_ptr_;
+
+			/// used to receive the pending datagrams with one recvmmsg call
+			udp_mmsg_recver                             mmsg_recver_;
+		};
+
 		/**
 		 * @constructor
+		 * @param    : concurrency - the size of the io_context pool, only the reuse port mode
+		 * uses more than one io_context, see reuse_port function.
 		 */
 		explicit udp_server_impl_t(
 			std::size_t init_buffer_size = udp_frame_size,
-			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)()
+			std::size_t max_buffer_size = (std::numeric_limits<std::size_t>::max)(),
+			std::size_t concurrency = 1
 		)
-			: super(1)
+			: super(concurrency)
 			, acceptor_(this->io_.context())
 			, remote_endpoint_()
 			, buffer_(init_buffer_size, max_buffer_size)
@@ -238,6 +296,62 @@ namespace asio2::detail
 		 */
 		inline asio::ip::udp::socket & acceptor() { return this->acceptor_; }
 
+		/**
+		 * @function : set whether open a SO_REUSEPORT udp socket for each io_context of the iopool,
+		 * the kernel distributes the datagrams across the sockets by the 4-tuple hash, so the
+		 * datagrams of a remote endpoint are always received by the same socket, and its session
+		 * is running on the io_context of that socket. The concurrency of the constructor must be
+		 * greater than 1, and this function must be called before the server starts.
+		 * If the SO_REUSEPORT option is not supported by the platform, only one socket is opened.
+		 */
+		inline derived_t & reuse_port(bool enable)
+		{
+			this->reuse_port_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the SO_REUSEPORT multi sockets mode is enabled
+		 */
+		inline bool is_reuse_port() const { return this->reuse_port_; }
+
+		/**
+		 * @function : set whether use the segmentation offload of the linux kernel, the kcp datagrams
+		 * of a session are sent by one UDP_SEGMENT datagram, and the datagrams of a remote endpoint
+		 * are received in one UDP_GRO coalesced buffer, it reduces the per datagram cost of the bulk
+		 * transfer. It's ignored if the kernel doesn't support it, and the recv buffer of each socket
+		 * is enlarged to 2MB when it's enabled. This function must be called before the server starts.
+		 */
+		inline derived_t & segment_offload(bool enable)
+		{
+			this->segment_offload_ = enable;
+			return (this->derived());
+		}
+
+		/**
+		 * @function : check whether the segmentation offload is enabled
+		 */
+		inline bool is_segment_offload() const { return this->segment_offload_; }
+
+		/**
+		 * @function : enable the timed batching of the sessions, the packed datagrams of the clients
+		 * are split before they are passed to the recv listener, and the small messages which are sent
+		 * by a session in the batch window are packed into one datagram. It's not used for the kcp
+		 * mode. This function should be called before the server starts.
+		 * @param    : delay - the max time which a message waits in the batch
+		 * @param    : max_size - the max size of the packed datagram, 0 means disable the batching, it's
+		 * clamped to the recv buffer size.
+		 */
+		template<class Rep, class Period>
+		inline derived_t & batch_window(std::chrono::duration<Rep, Period> delay, std::size_t max_size = udp_frame_size)
+		{
+			ASIO2_ASSERT(max_size <= this->buffer_.pre_size());
+
+			this->batch_delay_ = std::chrono::duration_cast<std::chrono::microseconds>(delay);
+			this->batch_size_  = max_size;
+			return (this->derived());
+		}
+
 	protected:
 		template<typename String, typename StrOrInt, typename MatchCondition>
 		bool _do_start(String&& host, StrOrInt&& service, condition_wrap<MatchCondition> condition)
@@ -275,6 +389,34 @@ namespace asio2::detail
 
 				this->acceptor_.close(ec_ignore);
 
+				// the iopool was stopped already, so all the handlers of the reuse port sockets
+				// have completed, and it's safe to reset them at here.
+				this->table_.clear();
+
+				for (auto & rs : this->reuse_sockets_)
+				{
+					rs->socket_.close(ec_ignore);
+					rs->counter_ptr_.reset();
+					rs->table_.clear();
+				}
+
+				// the first io_context is used by the acceptor_, a reuse port socket is created for each
+				// of the others only when the reuse port mode is enabled. they are changed only at here
+				// while the server is stopped, so the session managers of them can be visited in the
+				// other threads while the server is running.
+				if (this->reuse_port_ && this->reuse_sockets_.empty())
+				{
+					for (std::size_t i = 1; i < this->iopool_.size(); ++i)
+					{
+						this->reuse_sockets_.emplace_back(std::make_unique<reuse_socket>(
+							this->iopool_.get(i), this->buffer_.pre_size(), this->buffer_.max_size()));
+					}
+				}
+				else if (!this->reuse_port_)
+				{
+					this->reuse_sockets_.clear();
+				}
+
 				std::string h = to_string(std::forward<String>(host));
 				std::string p = to_string(std::forward<StrOrInt>(service));
 
@@ -291,6 +433,11 @@ namespace asio2::detail
 				// seconds later,so we can use the SO_REUSEADDR option to avoid this problem,like below
 				this->acceptor_.set_option(asio::ip::udp::socket::reuse_address(true)); // set port reuse
 
+			#if defined(SO_REUSEPORT)
+				if (this->reuse_port_ && !this->reuse_sockets_.empty())
+					this->acceptor_.set_option(socket_reuse_port(true));
+			#endif
+
 				//// Join the multicast group. you can set this option in the on_init(_fire_init) function.
 				//this->acceptor_.set_option(
 				//	// for ipv6, the host must be a ipv6 address like 0::0
@@ -302,6 +449,34 @@ namespace asio2::detail
 
 				this->acceptor_.bind(endpoint);
 
+			#if defined(SO_REUSEPORT)
+				if (this->reuse_port_ && !this->reuse_sockets_.empty())
+				{
+					// the service maybe "0", so we use the real local endpoint of the first socket.
+					endpoint = this->acceptor_.local_endpoint();
+
+					for (auto & rs : this->reuse_sockets_)
+					{
+						rs->counter_ptr_ = this->counter_ptr_;
+
+						rs->socket_.open(endpoint.protocol());
+						rs->socket_.set_option(asio::ip::udp::socket::reuse_address(true));
+						rs->socket_.set_option(socket_reuse_port(true));
+						rs->socket_.bind(endpoint);
+					}
+				}
+			#endif
+
+				// enable the segmentation offload if it's supported by the kernel
+				this->gso_ = (this->segment_offload_ && udp_gso_supported(this->acceptor_));
+				this->mmsg_recver_.set_gro(this->segment_offload_ && udp_enable_gro(this->acceptor_));
+
+				for (auto & rs : this->reuse_sockets_)
+				{
+					rs->mmsg_recver_.set_gro(this->segment_offload_ && rs->socket_.is_open() &&
+						udp_enable_gro(rs->socket_));
+				}
+
 				this->derived()._handle_start(error_code{}, std::move(condition));
 
 				return (this->is_started());
@@ -341,6 +516,19 @@ namespace asio2::detail
 
 					this->derived()._post_recv(std::move(condition));
 				});
+
+				for (auto & rs : this->reuse_sockets_)
+				{
+					if (!rs->socket_.is_open())
+						continue;
+
+					asio::post(rs->io_.strand(), [this, rs = rs.get(), condition]()
+					{
+						rs->buffer_.consume(rs->buffer_.size());
+
+						this->derived()._post_recv(*rs, std::move(condition));
+					});
+				}
 			}
 			catch (system_error & e)
 			{
@@ -379,6 +567,26 @@ namespace asio2::detail
 					session_ptr->stop();
 				});
 
+				// the reuse port sockets and their sessions must be stopped in their own io_context thread.
+				for (auto & rs : this->reuse_sockets_)
+				{
+					asio::post(rs->io_.strand(), [rs = rs.get()]()
+					{
+						rs->sessions_.foreach([](std::shared_ptr<session_t> & session_ptr)
+						{
+							session_ptr->stop();
+						});
+
+						// the queued datagrams hold the handle of the socket, send them before closing
+						udp_mmsg_sender::this_thread_sender().flush();
+
+						rs->socket_.shutdown(asio::socket_base::shutdown_both, ec_ignore);
+						rs->socket_.close(ec_ignore);
+
+						rs->counter_ptr_.reset();
+					});
+				}
+
 				this->counter_ptr_.reset();
 			});
 		}
@@ -392,6 +600,9 @@ namespace asio2::detail
 			// call the base class stop function
 			super::stop();
 
+			// the queued datagrams hold the handle of the socket, send them before closing
+			udp_mmsg_sender::this_thread_sender().flush();
+
 			// Call shutdown() to indicate that you will not write any more data to the socket.
 			this->acceptor_.shutdown(asio::socket_base::shutdown_both, ec_ignore);
 			// Call close,otherwise the _handle_recv will never return
@@ -406,6 +617,18 @@ namespace asio2::detail
 
 			try
 			{
+				// the coalesced datagrams must be received by recvmmsg which gets the segment size
+				if (this->mmsg_recver_.is_gro())
+				{
+					this->acceptor_.async_wait(asio::socket_base::wait_read,
+						asio::bind_executor(this->io_.strand(), make_allocator(this->rallocator_,
+							[this, condition](const error_code& ec)
+					{
+						this->derived()._handle_recv(ec, 0, condition);
+					})));
+					return;
+				}
+
 				this->acceptor_.async_receive_from(
 					this->buffer_.prepare(this->buffer_.pre_size()), this->remote_endpoint_,
 					asio::bind_executor(this->io_.strand(), make_allocator(this->rallocator_,
@@ -437,69 +660,153 @@ namespace asio2::detail
 
 			this->buffer_.commit(bytes_recvd);
 
+			if (!ec && !this->mmsg_recver_.is_gro())
+			{
+				this->derived()._handle_datagram(nullptr, std::string_view(static_cast
+					<std::string_view::const_pointer>(this->buffer_.data().data()), bytes_recvd), condition);
+			}
+
+			this->buffer_.consume(this->buffer_.size());
+
+			// drain the other pending datagrams with one recvmmsg call, and dispatch them in one pass
 			if (!ec)
 			{
-				std::string_view s = std::string_view(static_cast<std::string_view::const_pointer>
-					(this->buffer_.data().data()), bytes_recvd);
+				this->mmsg_recver_.recv(this->acceptor_, this->buffer_.pre_size(),
+					[this, &condition](asio::ip::udp::endpoint& endpoint, std::string_view s)
+				{
+					this->remote_endpoint_ = endpoint;
+
+					this->derived()._handle_datagram(nullptr, s, condition);
+				});
+			}
+
+			// send the kcp datagrams which are generated in this handler run
+			udp_mmsg_sender::this_thread_sender().flush();
+
+			this->derived()._post_recv(condition);
+		}
+
+		/**
+		 * @function : dispatch the datagram to the session, the remote endpoint of the datagram
+		 * is the remote_endpoint_ of the acceptor or the reuse socket.
+		 * @param    : rs - the reuse socket which received the datagram, nullptr for the acceptor
+		 */
+		template<typename MatchCondition>
+		inline void _handle_datagram(reuse_socket * rs, std::string_view s, condition_wrap<MatchCondition> condition)
+		{
+			if (!this->is_started())
+				return;
+
+			error_code ec;
+
+			io_t                                      & io        = rs ? rs->io_              : this->io_;
+			udp_session_table<session_t>              & table     = rs ? rs->table_           : this->table_;
+			asio::ip::udp::endpoint                   & endpoint  = rs ? rs->remote_endpoint_ : this->remote_endpoint_;
+			handler_memory<size_op<>, std::true_type> & allocator = rs ? rs->wallocator_      : this->wallocator_;
+
+			// first we find whether the session is in the dispatch table already,if not ,
+			// we new a session and put it into the session_mgr pool
+			std::shared_ptr<session_t> session_ptr = table.find(endpoint);
+
+			if constexpr (std::is_same_v<MatchCondition, use_kcp_t>)
+			{
+				// the syn is replied with the cookie directly without creating the session, the session
+				// is created only when the client echoes a valid cookie by the ack or the kcp data.
+				if (s.size() == sizeof(kcp::kcphdr) && kcp::is_kcphdr_syn(s))
+				{
+					// the syn which is resent before the client recvd the synack, the session replies it
+					if (session_ptr && session_ptr->is_started() && session_ptr->kcp_ &&
+						session_ptr->kcp_->syn_seq_ == ((kcp::kcphdr*)(s.data()))->th_seq)
+					{
+						session_ptr->_handle_recv(ec, s, session_ptr, condition);
+						return;
+					}
+
+					// the client is restarted with the same endpoint, stop the old session
+					if (session_ptr)
+					{
+						fprintf(stderr, "DBG syn on old session started=%d port=%d\n", (int)session_ptr->is_started(), (int)endpoint.port());
+						if (session_ptr->kcp_)
+							session_ptr->kcp_->send_fin_ = false;
+						session_ptr->stop();
+					}
+
+					this->derived()._kcp_send_cookie(rs, s, condition);
+					return;
+				}
+
+				if (!session_ptr || !session_ptr->is_started())
+				{
+					std::uint32_t cookie = 0;
+					if (!kcp::kcp_cookie::parse(s, cookie) || !this->cookie_.verify(endpoint, cookie))
+						return;
+				}
 
-				// first we find whether the session is in the session_mgr pool already,if not ,
-				// we new a session and put it into the session_mgr pool
-				std::shared_ptr<session_t> session_ptr = this->sessions_.find(this->remote_endpoint_);
 				if (!session_ptr)
 				{
-					this->derived()._handle_accept(ec, s, session_ptr, condition);
+					this->derived()._handle_accept(ec, rs, s, session_ptr, condition);
 				}
-				else
+				// the old session is stopping, accept the new session after the old one is removed
+				else if (!session_ptr->is_started())
 				{
-					if constexpr (std::is_same_v<MatchCondition, use_kcp_t>)
+					fprintf(stderr, "DBG deferred accept port=%d size=%d\n", (int)endpoint.port(), (int)s.size());
+					auto task = [this, ec, rs, condition, session_ptr, first = std::string{ s.data(),s.size() }]() mutable
 					{
-						if (s.size() == sizeof(kcp::kcphdr))
-						{
-							if /**/ (kcp::is_kcphdr_syn(s))
-							{
-								if (session_ptr->kcp_)
-									session_ptr->kcp_->send_fin_ = false;
-								session_ptr->stop();
-
-								auto task = [this, ec, condition, session_ptr, syn = std::string{ s.data(),s.size() }]() mutable
-								{
-									this->derived()._handle_accept(ec, std::string_view{ syn }, session_ptr, condition);
-								};
+						this->derived()._handle_accept(ec, rs, std::string_view{ first }, session_ptr, condition);
+					};
 #if defined(ASIO2_SEND_CORE_ASYNC)
-								session_ptr->push_event([this, &session_ptr, t = std::move(task)]() mutable
-								{
-									auto task = [this, &session_ptr, t = std::move(t)]() mutable
-									{
-										t();
-										session_ptr->next_event();
-									};
-									asio::post(this->io_.strand(), make_allocator(this->wallocator_, std::move(task)));
-									return true;
-								});
+					session_ptr->push_event([pio = &io, palloc = &allocator, session_ptr, t = std::move(task)]() mutable
+					{
+						auto task = [session_ptr, t = std::move(t)]() mutable
+						{
+							t();
+							session_ptr->next_event();
+						};
+						asio::post(pio->strand(), make_allocator(*palloc, std::move(task)));
+						return true;
+					});
 #else
-								asio::post(this->io_.strand(), make_allocator(this->wallocator_, std::move(task)));
+					asio::post(io.strand(), make_allocator(allocator, std::move(task)));
 #endif
-							}
-							else
-							{
-								std::ignore = true;
-							}
-						}
-						else
-						{
-							session_ptr->_handle_recv(ec, s, session_ptr, condition);
-						}
-					}
-					else
-					{
-						session_ptr->_handle_recv(ec, s, session_ptr, condition);
-					}
 				}
+				else
+				{
+					session_ptr->_handle_recv(ec, s, session_ptr, condition);
+				}
+			}
+			else
+			{
+				if (!session_ptr)
+					this->derived()._handle_accept(ec, rs, s, session_ptr, condition);
+				else
+					session_ptr->_handle_recv(ec, s, session_ptr, condition);
+			}
+		}
+
+		/**
+		 * @function : reply the syn with the synack which carries the cookie, nothing is allocated.
+		 * the fec shards requested by the client are accepted if the fec is enabled by the server.
+		 */
+		inline void _kcp_send_cookie(reuse_socket * rs, std::string_view syn, condition_wrap<use_kcp_t>& condition)
+		{
+			kcp::kcphdr * hdr = (kcp::kcphdr*)(syn.data());
+			const use_kcp_t & c = condition.kcp();
+
+			std::uint8_t fec_data = 0, fec_parity = 0;
+			if (c.fec_data_shards > 0 && c.fec_parity_shards > 0 && hdr->th_fec_data > 0 && hdr->th_fec_parity > 0)
+			{
+				fec_data   = static_cast<std::uint8_t>(hdr->th_fec_data);
+				fec_parity = static_cast<std::uint8_t>(hdr->th_fec_parity);
 			}
 
-			this->buffer_.consume(this->buffer_.size());
+			asio::ip::udp::endpoint & endpoint = rs ? rs->remote_endpoint_ : this->remote_endpoint_;
 
-			this->derived()._post_recv(condition);
+			kcp::kcphdr synack = kcp::make_kcphdr_synack(this->cookie_.make(endpoint, fec_data, fec_parity),
+				hdr->th_seq, fec_data, fec_parity);
+
+			error_code ec;
+			(rs ? rs->socket_ : this->acceptor_).send_to(asio::buffer(
+				(const void*)&synack, sizeof(kcp::kcphdr)), endpoint, 0, ec);
 		}
 
 		template<typename... Args>
@@ -508,6 +815,7 @@ namespace asio2::detail
 			return std::make_shared<session_t>(
 				std::forward<Args>(args)...,
 				this->sessions_,
+				this->table_,
 				this->listener_,
 				this->io_,
 				this->buffer_.pre_size(),
@@ -523,10 +831,133 @@ namespace asio2::detail
 		{
 			session_ptr = this->derived()._make_session();
 			session_ptr->counter_ptr_ = this->counter_ptr_;
+			session_ptr->gso_ = this->gso_;
+			session_ptr->batch_window(this->batch_delay_, this->batch_size_);
+			session_ptr->first_ = first;
+			session_ptr->start(condition);
+		}
+
+		template<typename MatchCondition>
+		inline void _post_recv(reuse_socket & rs, condition_wrap<MatchCondition> condition)
+		{
+			if (!this->is_started() || !rs.socket_.is_open())
+				return;
+
+			try
+			{
+				// the coalesced datagrams must be received by recvmmsg which gets the segment size
+				if (rs.mmsg_recver_.is_gro())
+				{
+					rs.socket_.async_wait(asio::socket_base::wait_read,
+						asio::bind_executor(rs.io_.strand(), make_allocator(rs.rallocator_,
+							[this, &rs, condition](const error_code& ec)
+					{
+						this->derived()._handle_recv(ec, rs, 0, condition);
+					})));
+					return;
+				}
+
+				rs.socket_.async_receive_from(
+					rs.buffer_.prepare(rs.buffer_.pre_size()), rs.remote_endpoint_,
+					asio::bind_executor(rs.io_.strand(), make_allocator(rs.rallocator_,
+						[this, &rs, condition](const error_code& ec, std::size_t bytes_recvd)
+				{
+					this->derived()._handle_recv(ec, rs, bytes_recvd, condition);
+				})));
+			}
+			catch (system_error & e)
+			{
+				set_last_error(e);
+				this->derived()._do_stop(e.code());
+			}
+		}
+
+		template<typename MatchCondition>
+		inline void _handle_recv(const error_code& ec, reuse_socket & rs, std::size_t bytes_recvd,
+			condition_wrap<MatchCondition> condition)
+		{
+			set_last_error(ec);
+
+			if (ec == asio::error::operation_aborted)
+			{
+				this->derived()._do_stop(ec);
+				return;
+			}
+
+			if (!this->is_started() || !rs.counter_ptr_)
+				return;
+
+			rs.buffer_.commit(bytes_recvd);
+
+			// the session map of the reuse socket is only visited by the io_context thread of it,
+			// so there is no lock contention between the reuse sockets.
+			if (!ec && !rs.mmsg_recver_.is_gro())
+			{
+				this->derived()._handle_datagram(&rs, std::string_view(static_cast
+					<std::string_view::const_pointer>(rs.buffer_.data().data()), bytes_recvd), condition);
+			}
+
+			rs.buffer_.consume(rs.buffer_.size());
+
+			// drain the other pending datagrams with one recvmmsg call, and dispatch them in one pass
+			if (!ec)
+			{
+				rs.mmsg_recver_.recv(rs.socket_, rs.buffer_.pre_size(),
+					[this, &rs, &condition](asio::ip::udp::endpoint& endpoint, std::string_view s)
+				{
+					rs.remote_endpoint_ = endpoint;
+
+					this->derived()._handle_datagram(&rs, s, condition);
+				});
+			}
+
+			// send the kcp datagrams which are generated in this handler run
+			udp_mmsg_sender::this_thread_sender().flush();
+
+			this->derived()._post_recv(rs, condition);
+		}
+
+		template<typename MatchCondition>
+		inline void _handle_accept(const error_code & ec, reuse_socket * rs, std::string_view first,
+			std::shared_ptr<session_t> session_ptr, condition_wrap<MatchCondition> condition)
+		{
+			if (!rs)
+			{
+				this->derived()._handle_accept(ec, first, std::move(session_ptr), std::move(condition));
+				return;
+			}
+
+			session_ptr = std::make_shared<session_t>(
+				rs->sessions_,
+				rs->table_,
+				this->listener_,
+				rs->io_,
+				rs->buffer_.pre_size(),
+				rs->buffer_.max_size(),
+				rs->buffer_,
+				rs->socket_,
+				rs->remote_endpoint_);
+			session_ptr->counter_ptr_ = rs->counter_ptr_;
+			session_ptr->gso_ = this->gso_;
+			session_ptr->batch_window(this->batch_delay_, this->batch_size_);
 			session_ptr->first_ = first;
 			session_ptr->start(condition);
 		}
 
+		/**
+		 * @function : call the function for the session manager of the acceptor and each reuse socket
+		 */
+		template<class Function>
+		inline void _foreach_session_mgr(Function&& fn)
+		{
+			fn(this->sessions_);
+
+			for (auto & rs : this->reuse_sockets_)
+			{
+				fn(rs->sessions_);
+			}
+		}
+
 		inline void _fire_init()
 		{
 			this->listener_.notify(event::init);
@@ -551,6 +982,29 @@ namespace asio2::detail
 
 		/// buffer
 		asio2::buffer_wrap<asio2::linear_buffer> buffer_;
+
+		/// used to receive the pending datagrams with one recvmmsg call
+		udp_mmsg_recver          mmsg_recver_;
+
+		/// the endpoint to session dispatch table, it's only accessed in the acceptor io_context thread
+		udp_session_table<session_t> table_;
+
+		/// whether open a SO_REUSEPORT udp socket for each io_context
+		bool                     reuse_port_ = false;
+
+		/// whether use the segmentation offload, and whether the UDP_SEGMENT is supported
+		bool                     segment_offload_ = false;
+		bool                     gso_ = false;
+
+		/// the batch window of the sessions, the batching is disabled if the size is 0
+		std::chrono::microseconds batch_delay_ = std::chrono::microseconds(0);
+		std::size_t              batch_size_  = 0;
+
+		/// the SO_REUSEPORT udp sockets which are running on the other io_contexts
+		std::vector<std::unique_ptr<reuse_socket>> reuse_sockets_;
+
+		/// the stateless handshake cookie, just used for kcp mode
+		kcp::kcp_cookie          cookie_;
 	};
 }
 
@@ -17,7 +17,10 @@
 
 #include <asio2/base/session.hpp>
 #include <asio2/udp/impl/udp_send_op.hpp>
+#include <asio2/udp/component/udp_batch_cp.hpp>
 #include <asio2/udp/detail/kcp_util.hpp>
+#include <asio2/udp/detail/kcp_cookie.hpp>
+#include <asio2/udp/detail/udp_session_table.hpp>
 
 namespace asio2::detail
 {
@@ -28,6 +31,7 @@ namespace asio2::detail
 	class udp_session_impl_t
 		: public session_impl_t<derived_t, socket_t, buffer_t>
 		, public udp_send_op<derived_t, true>
+		, public udp_batch_cp<derived_t, true>
 	{
 		template <class, bool>                friend class user_timer_cp;
 		template <class>                      friend class post_cp;
@@ -37,6 +41,7 @@ namespace asio2::detail
 		template <class>                      friend class event_queue_cp;
 		template <class, bool>                friend class send_cp;
 		template <class, bool>                friend class udp_send_op;
+		template <class, bool>                friend class udp_batch_cp;
 		template <class, bool>                friend class kcp_stream_cp;
 		template <class>                      friend class session_mgr_t;
 		template <class, class, class>        friend class session_impl_t;
@@ -54,6 +59,7 @@ namespace asio2::detail
 		 */
 		explicit udp_session_impl_t(
 			session_mgr_t<derived_t> & sessions,
+			udp_session_table<derived_t> & table,
 			listener_t & listener,
 			io_t & rwio,
 			std::size_t init_buffer_size,
@@ -64,6 +70,8 @@ namespace asio2::detail
 		)
 			: super(sessions, listener, rwio, init_buffer_size, max_buffer_size, socket)
 			, udp_send_op<derived_t, true>()
+			, udp_batch_cp<derived_t, true>(rwio)
+			, table_(table)
 			, buffer_ref_(buffer)
 			, remote_endpoint_(endpoint)
 			, wallocator_()
@@ -164,6 +172,33 @@ namespace asio2::detail
 			return (this->kcp_ ? this->kcp_->kcp_ : nullptr);
 		}
 
+		/**
+		 * @function : get the kcp options, just used for kcp mode
+		 */
+		inline detail::kcp_option kcp_option() const
+		{
+			return (this->kcp_ ? this->kcp_->_get_option() : detail::kcp_option{});
+		}
+
+		/**
+		 * @function : change the kcp options at runtime, just used for kcp mode
+		 * eg : kcp_option(asio2::kcp_option::normal()) for the bulk transfer.
+		 */
+		inline derived_t & kcp_option(const detail::kcp_option & opt)
+		{
+			if (this->kcp_)
+				this->kcp_->_set_option(opt);
+			return (this->derived());
+		}
+
+		/**
+		 * @function : get the transport statistics of the kcp, just used for kcp mode
+		 */
+		inline kcp::kcp_stats kcp_stats() const
+		{
+			return (this->kcp_ ? this->kcp_->_get_stats() : kcp::kcp_stats{});
+		}
+
 	protected:
 		template<typename MatchCondition>
 		inline void _do_init(std::shared_ptr<derived_t> this_ptr, condition_wrap<MatchCondition> condition)
@@ -180,9 +215,10 @@ namespace asio2::detail
 		{
 			if constexpr (std::is_same_v<MatchCondition, use_kcp_t>)
 			{
-				// step 3 : server recvd syn from client (the first_ is syn)
-				// Check whether the first_ packet is SYN handshake
-				if (!kcp::is_kcphdr_syn(this->first_))
+				// step 5 : server recvd the ack or the kcp data which carries the cookie from client
+				// Check whether the first_ packet carries the cookie, it's verified by the server already
+				std::uint32_t cookie = 0;
+				if (!kcp::kcp_cookie::parse(this->first_, cookie))
 				{
 					set_last_error(asio::error::no_protocol_option);
 					this->derived()._fire_handshake(this_ptr, asio::error::no_protocol_option);
@@ -259,8 +295,12 @@ namespace asio2::detail
 				// All pending sending events will be cancelled after enter the strand below.
 
 				// Second ensure that this session has removed from the session map.
-				this->sessions_.erase(this_ptr, [this, ec, this_ptr, old_state](bool)
+				this->sessions_.erase(this_ptr, [this, ec, this_ptr, old_state](bool erased)
 				{
+					// the erase callback is called on the strand which receives the datagrams
+					if (erased)
+						this->table_.erase(this_ptr);
+
 					set_last_error(ec);
 
 					state_t expected = state_t::stopping;
@@ -310,6 +350,9 @@ namespace asio2::detail
 		{
 			detail::ignore::unused(ec);
 
+			// send the pending packed datagram
+			this->derived()._batch_stop();
+
 			if (this->kcp_)
 				this->kcp_->_kcp_stop(std::move(this_ptr));
 		}
@@ -320,7 +363,11 @@ namespace asio2::detail
 			this->sessions_.emplace(this_ptr, [this, this_ptr, condition](bool inserted) mutable
 			{
 				if (inserted)
+				{
+					// the emplace callback is called on the strand which receives the datagrams
+					this->table_.emplace(this_ptr);
 					this->derived()._start_recv(std::move(this_ptr), condition);
+				}
 				else
 					this->derived()._do_disconnect(asio::error::address_in_use);
 			});
@@ -332,8 +379,12 @@ namespace asio2::detail
 			// start the timer of check silence timeout
 			this->derived()._post_silence_timer(this->silence_timeout_, this_ptr);
 
+			// in kcp mode, the first_ is the ack of the handshake or the first kcp data if the ack is lost
 			if constexpr (std::is_same_v<MatchCondition, use_kcp_t>)
-				std::ignore = true;
+			{
+				if (this->first_.size() != sizeof(kcp::kcphdr))
+					this->derived()._handle_recv(error_code{}, this->first_, this_ptr, condition);
+			}
 			else
 				this->derived()._handle_recv(error_code{}, this->first_, this_ptr, condition);
 		}
@@ -343,7 +394,11 @@ namespace asio2::detail
 		inline bool _do_send(Data& data, Callback&& callback)
 		{
 			if (!this->kcp_)
+			{
+				if (this->is_batch())
+					return this->derived()._batch_send(data, std::forward<Callback>(callback));
 				return this->derived()._udp_send_to(this->remote_endpoint_, data, std::forward<Callback>(callback));
+			}
 			return this->kcp_->_kcp_send(data, std::forward<Callback>(callback));
 		}
 
@@ -359,7 +414,14 @@ namespace asio2::detail
 
 			if constexpr (!std::is_same_v<MatchCondition, use_kcp_t>)
 			{
-				this->derived()._fire_recv(this_ptr, std::move(s));
+				// split the packed datagram if the batching is enabled
+				if (!this->derived()._batch_recv(s, [this, &this_ptr](std::string_view msg)
+				{
+					this->derived()._fire_recv(this_ptr, std::move(msg));
+				}))
+				{
+					this->derived()._fire_recv(this_ptr, std::move(s));
+				}
 			}
 			else
 			{
@@ -378,12 +440,19 @@ namespace asio2::detail
 						ASIO2_ASSERT(this->kcp_ && this->kcp_->kcp_);
 						// step 4 : server send synack to client
 						kcp::kcphdr * hdr = (kcp::kcphdr*)(s.data());
-						kcp::kcphdr synack = kcp::make_kcphdr_synack(this->kcp_->seq_, hdr->th_seq);
+						kcp::kcphdr synack = kcp::make_kcphdr_synack(this->kcp_->seq_, hdr->th_seq,
+							this->kcp_->_fec_data_shards(), this->kcp_->_fec_parity_shards());
 						error_code ed;
 						this->kcp_->_kcp_send_hdr(synack, ed);
 						if (ed)
 							this->derived()._do_disconnect(ed);
 					}
+					// the client resends the ack until it recvd the confirmation of the ack
+					else if (kcp::is_kcphdr_ack(s, this->kcp_->seq_))
+					{
+						error_code ed;
+						this->kcp_->_kcp_send_hdr(kcp::make_kcphdr_ack(this->kcp_->seq_), ed);
+					}
 				}
 				else
 					this->kcp_->_kcp_recv(this_ptr, s, this->buffer_ref_);
@@ -421,6 +490,9 @@ namespace asio2::detail
 		inline auto & wallocator() { return this->wallocator_; }
 
 	protected:
+		/// the endpoint to session dispatch table of the socket which receives the datagrams
+		udp_session_table<derived_t>                  & table_;
+
 		/// buffer
 		asio2::buffer_wrap<asio2::linear_buffer>      & buffer_ref_;
 
@@ -434,6 +506,9 @@ namespace asio2::detail
 
 		/// first recvd data packet
 		std::string_view                                first_;
+
+		/// whether use the UDP_SEGMENT to send the kcp datagrams, it's set by the server
+		bool                                            gso_ = false;
 	};
 }
 
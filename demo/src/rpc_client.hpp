@@ -48,7 +48,7 @@ void run_rpc_client(std::string_view host, std::string_view port)
 			client.bind("sub", [](int a, int b) { return a - b; });
 
 			// Using tcp dgram mode as the underlying communication support(This is the default setting)
-			// Then must use "use_dgram" parameter.
+			// The "use_dgram" parameter is used even if it's omitted.
 			client.start(host, port, asio2::use_dgram);
 
 			// Using websocket as the underlying communication support.
@@ -111,7 +111,7 @@ void run_rpc_server(std::string_view host, std::string_view port)
 		server.bind("del_user", &A::del_user, &a);
 
 		// Using tcp dgram mode as the underlying communication support(This is the default setting)
-		// Then must use "use_dgram" parameter.
+		// The "use_dgram" parameter is used even if it's omitted.
 		server.start(host, port, asio2::use_dgram);
 
 		// Using websocket as the underlying communication support.